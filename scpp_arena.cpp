@@ -0,0 +1,76 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#include "scpp_arena.hpp"
+
+#include <stdlib.h>	// malloc, free
+
+namespace scpp {
+Arena::Arena(size_t block_size)
+: block_size_(block_size), current_(NULL), used_(0), spare_(NULL), bytes_reserved_(0)
+{
+	SCPP_ASSERT(block_size > 0, "Arena block size must be positive");
+}
+
+Arena::~Arena() {
+	Reset();
+	while(spare_ != NULL) {
+		Block* b = spare_;
+		spare_ = b->prev;
+		free(b);
+	}
+}
+
+void* Arena::AllocateSlow(size_t bytes, size_t alignment) {
+	size_t needed = bytes + alignment - 1;
+
+	// First spare block large enough, the list is short:
+	// one entry per block ever taken from the system.
+	Block** link = &spare_;
+	while(*link != NULL && (*link)->size < needed)
+		link = &(*link)->prev;
+
+	Block* b = *link;
+	if(b != NULL) {
+		*link = b->prev;
+	} else {
+		size_t size = needed > block_size_ ? needed : block_size_;
+		b = static_cast<Block*>(malloc(sizeof(Block) + size));
+		SCPP_ASSERT(b != NULL, "Arena: out of memory allocating " << size << " bytes");
+		b->size = size;
+		bytes_reserved_ += size;
+	}
+
+	b->prev = current_;
+	current_ = b;
+
+	char* base = b->Data();
+	size_t pos = AlignUp(base, alignment) - base;
+	used_ = pos + bytes;
+	return base + pos;
+}
+
+void Arena::Rewind(const Mark& mark) {
+	while(current_ != mark.block_) {
+		SCPP_ASSERT(current_ != NULL, "Arena: rewind to a mark of another arena");
+		Block* b = current_;
+		current_ = b->prev;
+		b->prev = spare_;
+		spare_ = b;
+	}
+	used_ = mark.used_;
+}
+
+void Arena::Reset() {
+	Rewind(Mark());
+}
+} // namespace scpp
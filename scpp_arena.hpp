@@ -0,0 +1,215 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#ifndef __SCPP_ARENA_HPP_INCLUDED__
+#define __SCPP_ARENA_HPP_INCLUDED__
+
+#include <stddef.h>	// size_t, ptrdiff_t
+#include <stdint.h>	// uintptr_t
+#include <new>		// placement new
+#include <utility>	// forward
+
+#include "scpp_assert.hpp"
+
+/*
+	Arena (monotonic) memory resource.
+	Features:
+		Allocation is a pointer bump inside the current block.
+		Deallocation of individual objects does nothing,
+			all memory is released together by Reset() or by ArenaScope.
+		Blocks released by Reset() are kept and reused,
+			so in a steady state the arena does not call malloc at all.
+
+	Typical use -- all scratch containers of one request share one arena:
+
+		scpp::Arena arena;
+		...
+		{
+			scpp::ArenaScope scope(arena);
+			scpp::ArenaAllocator<double> alloc(arena);
+			scpp::vector<double, scpp::ArenaAllocator<double> > v(n, alloc);
+			scpp::matrix<double, scpp::ArenaAllocator<double> > m(r, c, alloc);
+			...
+		} // memory of v and m is returned to the arena here
+
+	Containers using the arena must not outlive the ArenaScope
+	(or the Reset() call) that covers them.
+	An Arena is not thread-safe: use one arena per thread or per request.
+	Requires C++11 (alignof).
+*/
+namespace scpp {
+
+class Arena {
+  public:
+	// Memory is taken from the system in blocks of at least block_size bytes.
+	explicit Arena(size_t block_size = 64*1024);
+
+	~Arena();
+
+	// Returns memory for bytes bytes aligned to alignment (a power of 2).
+	void* Allocate(size_t bytes, size_t alignment) {
+		SCPP_TEST_ASSERT(alignment != 0 && (alignment & (alignment-1)) == 0,
+			"Alignment " << alignment << " must be a power of 2");
+		if(current_ != NULL) {
+			char* base = current_->Data();
+			size_t pos = AlignUp(base + used_, alignment) - base;
+			if(pos + bytes <= current_->size) {
+				used_ = pos + bytes;
+				return base + pos;
+			}
+		}
+		return AllocateSlow(bytes, alignment);
+	}
+
+	// Position in the arena, see Rewind().
+	class Mark {
+	  public:
+		// Beginning of the arena.
+		Mark()
+		: block_(NULL), used_(0) {
+		}
+
+	  private:
+		friend class Arena;
+		void*	block_;
+		size_t	used_;
+	};
+
+	Mark GetMark() const {
+		Mark m;
+		m.block_ = current_;
+		m.used_ = used_;
+		return m;
+	}
+
+	// Releases everything allocated after mark was taken.
+	void Rewind(const Mark& mark);
+
+	// Releases everything allocated from the arena.
+	void Reset();
+
+	// Number of bytes currently held from the system.
+	size_t BytesReserved() const { return bytes_reserved_; }
+
+  private:
+	struct Block {
+		Block*	prev;	// previously used block
+		size_t	size;	// usable bytes after the header
+
+		char* Data() { return reinterpret_cast<char*>(this + 1); }
+	};
+
+	size_t	block_size_;
+	Block*	current_;	// block being filled, its prev chain is in use too
+	size_t	used_;		// bytes used in current_
+	Block*	spare_;		// released blocks kept for reuse, most recent first
+	size_t	bytes_reserved_;
+
+	void* AllocateSlow(size_t bytes, size_t alignment);
+
+	static char* AlignUp(char* p, size_t alignment) {
+		uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+		return p + (((addr + alignment - 1) & ~(alignment - 1)) - addr);
+	}
+
+	// Copy is prohibited:
+	Arena(const Arena&);
+	Arena& operator=(const Arena&);
+};
+
+// Rewinds the arena on exit from a scope to where it was on entry.
+class ArenaScope {
+  public:
+	explicit ArenaScope(Arena& arena)
+	: arena_(arena), mark_(arena.GetMark()) {
+	}
+
+	~ArenaScope() {
+		arena_.Rewind(mark_);
+	}
+
+  private:
+	Arena&		arena_;
+	Arena::Mark	mark_;
+
+	// Copy is prohibited:
+	ArenaScope(const ArenaScope&);
+	ArenaScope& operator=(const ArenaScope&);
+};
+
+// Standard allocator taking memory from an Arena,
+// for use with scpp::vector, scpp::matrix and std containers.
+template <typename T>
+class ArenaAllocator {
+  public:
+	typedef T			value_type;
+	typedef T*			pointer;
+	typedef const T*	const_pointer;
+	typedef T&			reference;
+	typedef const T&	const_reference;
+	typedef size_t		size_type;
+	typedef ptrdiff_t	difference_type;
+
+	template <typename U>
+	struct rebind { typedef ArenaAllocator<U> other; };
+
+	explicit ArenaAllocator(Arena& arena)
+	: arena_(&arena) {
+	}
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& that)
+	: arena_(that.GetArena()) {
+	}
+
+	Arena* GetArena() const { return arena_; }
+
+	pointer address(reference x) const { return &x; }
+	const_pointer address(const_reference x) const { return &x; }
+
+	pointer allocate(size_type n, const void* /*hint*/ = 0) {
+		SCPP_ASSERT(n <= max_size(), "Too many elements requested: " << n);
+		return static_cast<pointer>(
+			arena_->Allocate(n * sizeof(T), alignof(T)));
+	}
+
+	// Memory is returned to the arena only by Reset() or ArenaScope.
+	void deallocate(pointer /*p*/, size_type /*n*/) {
+	}
+
+	size_type max_size() const { return size_type(-1) / sizeof(T); }
+
+	// Forwards the arguments, so that containers move their elements
+	// on reallocation and can hold move-only types.
+	template <typename U, typename... Args>
+	void construct(U* p, Args&&... args) { new((void*)p) U(std::forward<Args>(args)...); }
+
+	template <typename U>
+	void destroy(U* p) { p->~U(); }
+
+  private:
+	Arena*	arena_;
+};
+
+template <typename T, typename U>
+inline bool operator == (const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {
+	return lhs.GetArena() == rhs.GetArena();
+}
+
+template <typename T, typename U>
+inline bool operator != (const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {
+	return lhs.GetArena() != rhs.GetArena();
+}
+
+} // namespace scpp
+
+#endif // __SCPP_ARENA_HPP_INCLUDED__
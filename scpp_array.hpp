@@ -14,14 +14,17 @@
 #define __SCPP_ARRAY_HPP_INCLUDED__
 
 #include "scpp_assert.hpp"
+#include "scpp_check_policy.hpp"
+#include "scpp_types.hpp"
 
 namespace scpp {
 
 // Fixed-size array
-template <typename T, unsigned N>
+// The checks are controlled by the policy Check (see scpp_check_policy.hpp).
+template <typename T, unsigned N, typename Check = DefaultCheck>
 class array {
  public:
-	typedef unsigned size_type;	
+	typedef unsigned64 size_type;	
 	
 	// Most commonly used constructors:
 	array() {}
@@ -36,13 +39,13 @@ class array {
 	// we rely on default versions of these methods generated by the compiler.
 	
 	T& operator [] (size_type index) {
-		SCPP_TEST_ASSERT(index < N,
+		SCPP_CHECK(Check, index < N,
 			"Index " << index << " must be less than " << N);
 		return data_[index];
 	}
 
 	const T& operator [] (size_type index) const {
-		SCPP_TEST_ASSERT(index < N,
+		SCPP_CHECK(Check, index < N,
 			"Index " << index << " must be less than " << N);
 		return data_[index];
 	}
@@ -61,10 +64,10 @@ class array {
 } // namespace scpp
 
 
-template <typename T, unsigned N>
+template <typename T, unsigned N, typename Check>
 inline
-std::ostream& operator << (std::ostream& os, const scpp::array<T,N>& a) {
-	for( unsigned i=0; i<a.size(); ++i ) {
+std::ostream& operator << (std::ostream& os, const scpp::array<T,N,Check>& a) {
+	for( unsigned64 i=0; i<a.size(); ++i ) {
 		os << a[i];
 		if( i + 1 < a.size() )
 				os << " ";
@@ -12,8 +12,11 @@
 
 #include "scpp_assert.hpp"
 
+#include <atomic>
 #include <iostream>	// cerr, endl, flush
+#include <stdio.h>	// snprintf
 #include <stdlib.h>	// exit()
+#include <string.h>	// strlen, memcpy
 
 
 using namespace std;
@@ -23,20 +26,197 @@ namespace scpp {
 	ScppAssertFailedException::ScppAssertFailedException(const char* file_name,
 														 unsigned line_number,
 														 const char* message) {
-		ostringstream s;
-		s << "SCPP assertion failed with message '" << message
-		  << "' in file " << file_name << " #" << line_number;
-		
-		what_ = s.str();
+		snprintf(what_, sizeof(what_),
+				 "SCPP assertion failed with message '%s' in file %s #%u",
+				 message, file_name, line_number);
 	}
 }
 #endif
 
+namespace scpp {
+namespace {
+	// Stream buffer writing into the message of an AssertFormatter.
+	class MessageBuffer : public std::streambuf {
+	 public:
+		void Seat(char* begin, char* end, char* limit) {
+			setp(begin, limit);
+			pbump((int)(end - begin));
+		}
+
+		char* Begin() const { return pbase(); }
+		char* End() const { return pptr(); }
+		char* Limit() const { return epptr(); }
+	};
+
+	// Constructed on the first failure of the thread which writes a type
+	// without an overload in AssertFormatter, then only re-seated.
+	struct ThreadStream {
+		MessageBuffer	buffer;
+		std::ostream	stream;
+
+		ThreadStream()
+		: stream(&buffer) {
+		}
+	};
+
+	ThreadStream& GetThreadStream() {
+		static thread_local ThreadStream thread_stream;
+		return thread_stream;
+	}
+}
+
+	AssertFormatter::AssertFormatter()
+	: end_(data_), stream_taken_(false) {
+	}
+
+	// Gives the stream back to the formatter that had it before.
+	AssertFormatter::~AssertFormatter() {
+		if(!stream_taken_)
+			return;
+		ThreadStream& ts = GetThreadStream();
+		ts.buffer.Seat(saved_[0], saved_[1], saved_[2]);
+		ts.stream.clear();
+		if(saved_[0] == NULL) {
+			// Outermost message: forget its manipulators.
+			ts.stream.flags(ios_base::dec | ios_base::skipws);
+			ts.stream.precision(6);
+			ts.stream.width(0);
+			ts.stream.fill(' ');
+		}
+	}
+
+	const char* AssertFormatter::c_str() {
+		if(stream_taken_)
+			end_ = GetThreadStream().buffer.End();
+		*end_ = '\0';
+		return data_;
+	}
+
+	AssertFormatter::operator std::ostream& () {
+		ThreadStream& ts = GetThreadStream();
+		if(!stream_taken_) {
+			saved_[0] = ts.buffer.Begin();
+			saved_[1] = ts.buffer.End();
+			saved_[2] = ts.buffer.Limit();
+			// The last char is kept for the terminating '\0'.
+			ts.buffer.Seat(data_, end_, data_ + SCPP_ASSERT_MESSAGE_SIZE - 1);
+			ts.stream.clear();
+			stream_taken_ = true;
+		}
+		return ts.stream;
+	}
+
+	AssertFormatter& AssertFormatter::operator << (std::ostream& (*manipulator)(std::ostream&)) {
+		manipulator(*this);
+		return *this;
+	}
+
+	AssertFormatter& AssertFormatter::operator << (std::ios_base& (*manipulator)(std::ios_base&)) {
+		manipulator(*this);
+		return *this;
+	}
+
+	void AssertFormatter::Append(const char* s, unsigned n) {
+		if(stream_taken_) {
+			GetThreadStream().buffer.sputn(s, n);
+			return;
+		}
+		unsigned room = (unsigned)(data_ + SCPP_ASSERT_MESSAGE_SIZE - 1 - end_);
+		if(n > room)
+			n = room;
+		memcpy(end_, s, n);
+		end_ += n;
+	}
+
+	void AssertFormatter::AppendInteger(unsigned long long x, bool negative) {
+		char digits[24];
+		char* p = digits + sizeof(digits);
+		do {
+			*--p = (char)('0' + x % 10);
+			x /= 10;
+		} while(x != 0);
+		if(negative)
+			*--p = '-';
+		Append(p, (unsigned)(digits + sizeof(digits) - p));
+	}
+
+	AssertFormatter& AssertFormatter::operator << (const char* s) {
+		if(s == NULL)
+			s = "(null)";
+		Append(s, (unsigned)strlen(s));
+		return *this;
+	}
+
+	AssertFormatter& AssertFormatter::operator << (const std::string& s) {
+		Append(s.data(), (unsigned)s.size());
+		return *this;
+	}
+
+	AssertFormatter& AssertFormatter::operator << (char c) {
+		Append(&c, 1);
+		return *this;
+	}
+
+	// Like std::ostream: the character itself, not its code.
+	AssertFormatter& AssertFormatter::operator << (signed char c) { return *this << (char)c; }
+	AssertFormatter& AssertFormatter::operator << (unsigned char c) { return *this << (char)c; }
+
+	AssertFormatter& AssertFormatter::operator << (bool x) { return *this << (int)x; }
+	AssertFormatter& AssertFormatter::operator << (int x) { return *this << (long long)x; }
+	AssertFormatter& AssertFormatter::operator << (unsigned x) { return *this << (unsigned long long)x; }
+	AssertFormatter& AssertFormatter::operator << (long x) { return *this << (long long)x; }
+	AssertFormatter& AssertFormatter::operator << (unsigned long x) { return *this << (unsigned long long)x; }
+
+	AssertFormatter& AssertFormatter::operator << (long long x) {
+		// -x would overflow for the most negative value
+		AppendInteger(x < 0 ? 0ULL - (unsigned long long)x : (unsigned long long)x, x < 0);
+		return *this;
+	}
+
+	AssertFormatter& AssertFormatter::operator << (unsigned long long x) {
+		AppendInteger(x, false);
+		return *this;
+	}
+
+	AssertFormatter& AssertFormatter::operator << (double x) {
+		char s[32];
+		int n = snprintf(s, sizeof(s), "%g", x);
+		Append(s, n > 0 ? (unsigned)n : 0);
+		return *this;
+	}
+
+	AssertFormatter& AssertFormatter::operator << (long double x) {
+		char s[48];
+		int n = snprintf(s, sizeof(s), "%Lg", x);
+		Append(s, n > 0 ? (unsigned)n : 0);
+		return *this;
+	}
+
+	AssertFormatter& AssertFormatter::operator << (const void* p) {
+		char s[32];
+		int n = snprintf(s, sizeof(s), "%p", p);
+		Append(s, n > 0 ? (unsigned)n : 0);
+		return *this;
+	}
+}
+
+static atomic<SCPP_AssertHandlerFunc> scpp_assert_handler(NULL);
+
+SCPP_AssertHandlerFunc SCPP_SetAssertHandler(SCPP_AssertHandlerFunc handler) {
+	return scpp_assert_handler.exchange(handler);
+}
+
 void SCPP_AssertErrorHandler(const char* file_name,
 							 unsigned line_number,
 							 const char* message) {
 	// This is a good place to put your debug breakpoint:
 	// You can also add writing of the same info into a log file if appropriate.
+
+	SCPP_AssertHandlerFunc handler = scpp_assert_handler.load(memory_order_acquire);
+	if(handler != NULL) {
+		handler(file_name, line_number, message);
+		return;
+	}
 	
 #ifdef SCPP_THROW_EXCEPTION_ON_BUG
 	throw scpp::ScppAssertFailedException(file_name, line_number, message);
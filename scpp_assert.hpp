@@ -14,6 +14,30 @@
 #define __SCPP_ASSERT_HPP_INCLUDED__
 
 #include <sstream> // ostringstream
+#include <string>
+
+#if __cplusplus >= 201103L
+#	define SCPP_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+#	define SCPP_THREAD_LOCAL __declspec(thread)
+#else
+#	define SCPP_THREAD_LOCAL __thread
+#endif
+
+// The failure path is marked cold and never inlined,
+// so that a check costs only a compare and a branch at the call site.
+#if defined(__GNUC__)
+#	define SCPP_COLD __attribute__((cold, noinline))
+#	define SCPP_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#	define SCPP_COLD
+#	define SCPP_UNLIKELY(x) (x)
+#endif
+
+// Maximum length of a failure message, longer ones are truncated.
+#ifndef SCPP_ASSERT_MESSAGE_SIZE
+#	define SCPP_ASSERT_MESSAGE_SIZE 512
+#endif
 
 #ifdef SCPP_THROW_EXCEPTION_ON_BUG
 #include <exception>
@@ -27,27 +51,122 @@ class ScppAssertFailedException : public std::exception {
 							  unsigned line_number,
 							  const char* message);
 	
-	virtual const char* what() const throw () { return what_.c_str(); }
+	virtual const char* what() const throw () { return what_; }
 							  
 	virtual ~ScppAssertFailedException() throw () {}
  private:
-  std::string what_;
+  char what_[SCPP_ASSERT_MESSAGE_SIZE + 128];
 };
 } // namespace scpp
 #endif
 
-void SCPP_AssertErrorHandler(const char* file_name,
-							 unsigned line_number,
-							 const char* message);
+namespace scpp {
+// Formats a failure message into a fixed buffer of its own, used instead
+// of std::ostringstream so that a failed check neither allocates memory
+// nor constructs a stream with its locale. Strings, characters and numbers
+// are formatted directly. Other types are written by their operator <<
+// for std::ostream into a stream constructed once per thread, which is
+// pointed at this formatter's buffer for the rest of the message.
+// A check failing inside such operator << gets a formatter of its own
+// and does not overwrite the message being formatted.
+class AssertFormatter {
+ public:
+	SCPP_COLD AssertFormatter();
+	SCPP_COLD ~AssertFormatter();
 
-// Permanent sanity check macro.
-#define SCPP_ASSERT(condition, msg)                 \
-    if(!(condition)) {                              \
-        std::ostringstream s;                       \
+	SCPP_COLD const char* c_str();
+
+	// The stream of this thread, writing into this formatter.
+	SCPP_COLD operator std::ostream& ();
+
+	// Manipulators apply to the types written through the stream only.
+	SCPP_COLD AssertFormatter& operator << (std::ostream& (*manipulator)(std::ostream&));
+	SCPP_COLD AssertFormatter& operator << (std::ios_base& (*manipulator)(std::ios_base&));
+
+	SCPP_COLD AssertFormatter& operator << (const char* s);
+	SCPP_COLD AssertFormatter& operator << (const std::string& s);
+	SCPP_COLD AssertFormatter& operator << (char c);
+	SCPP_COLD AssertFormatter& operator << (signed char c);
+	SCPP_COLD AssertFormatter& operator << (unsigned char c);
+	SCPP_COLD AssertFormatter& operator << (bool x);
+	SCPP_COLD AssertFormatter& operator << (int x);
+	SCPP_COLD AssertFormatter& operator << (unsigned x);
+	SCPP_COLD AssertFormatter& operator << (long x);
+	SCPP_COLD AssertFormatter& operator << (unsigned long x);
+	SCPP_COLD AssertFormatter& operator << (long long x);
+	SCPP_COLD AssertFormatter& operator << (unsigned long long x);
+	SCPP_COLD AssertFormatter& operator << (double x);
+	SCPP_COLD AssertFormatter& operator << (long double x);
+	SCPP_COLD AssertFormatter& operator << (const void* p);
+
+ private:
+	char	data_[SCPP_ASSERT_MESSAGE_SIZE];
+	char*	end_;			// of the message, while the stream is not taken
+	bool	stream_taken_;
+	char*	saved_[3];		// begin, end and limit of the message the stream
+							// was writing before it was taken, if any
+
+	// Silently truncates on overflow.
+	void Append(const char* s, unsigned n);
+	void AppendInteger(unsigned long long x, bool negative);
+
+	// Not copyable: the stream could point into data_.
+	AssertFormatter(const AssertFormatter&);
+	AssertFormatter& operator = (const AssertFormatter&);
+};
+} // namespace scpp
+
+SCPP_COLD void SCPP_AssertErrorHandler(const char* file_name,
+									   unsigned line_number,
+									   const char* message);
+
+// Pluggable error handler. If one is set, SCPP_AssertErrorHandler()
+// calls it instead of throwing or terminating the application,
+// and the execution continues after the failed check when it returns.
+// See e.g. scpp::StartAsyncAssertLog() in scpp_assert_log.hpp.
+typedef void (*SCPP_AssertHandlerFunc)(const char* file_name,
+									   unsigned line_number,
+									   const char* message);
+
+// Sets the handler (NULL restores the default behavior),
+// returns the previous one.
+SCPP_AssertHandlerFunc SCPP_SetAssertHandler(SCPP_AssertHandlerFunc handler);
+
+// Formats the message and calls the error handler,
+// used by SCPP_ASSERT and SCPP_CHECK (see scpp_check_policy.hpp).
+// With GCC in C++11 the whole failure path is moved out of line
+// into a cold lambda, so that even the inlined check sites stay small.
+#if defined(__GNUC__) && __cplusplus >= 201103L
+#define SCPP_ASSERT_FAILED(msg)                     \
+    {                                               \
+        [&]() __attribute__((cold, noinline)) {     \
+            scpp::AssertFormatter s;                \
+            s << msg;                               \
+            SCPP_AssertErrorHandler(                \
+                __FILE__, __LINE__, s.c_str() );    \
+        }();                                        \
+	}
+#else
+#define SCPP_ASSERT_FAILED(msg)                     \
+    {                                               \
+        scpp::AssertFormatter s;                    \
         s << msg;                                   \
         SCPP_AssertErrorHandler(                    \
-            __FILE__, __LINE__, s.str().c_str() );  \
+            __FILE__, __LINE__, s.c_str() );        \
 	}
+#endif
+
+// Counts the evaluations of each check site,
+// see SCPP_INSTRUMENT_CHECKS in scpp_instrument.hpp.
+#ifdef SCPP_INSTRUMENT_CHECKS
+#	include "scpp_instrument.hpp"
+#else
+#	define SCPP_COUNT_CHECK() true
+#endif
+
+// Permanent sanity check macro.
+#define SCPP_ASSERT(condition, msg)                 \
+    if(SCPP_COUNT_CHECK() && SCPP_UNLIKELY(!(condition))) SCPP_ASSERT_FAILED(msg)
 
 #ifdef _DEBUG
 #	define SCPP_TEST_ASSERT_ON
@@ -0,0 +1,343 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#include "scpp_assert_log.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <stdio.h>	// fopen, fprintf
+#include <string.h>	// strncpy, strcmp
+#include <time.h>	// gmtime_r, gmtime_s
+
+namespace scpp {
+namespace {
+
+enum {
+	SITE_TABLE_SIZE = 4096,	// must be a power of 2
+	RING_SIZE = 256,		// reports per thread waiting to be written
+	MAX_THREADS = 64,		// threads with a ring at the same time
+	MAX_MESSAGE = 232		// longer messages are truncated
+};
+
+unsigned64 NowNanoseconds() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Statistics of one check site, identified by (file_name, line_number).
+struct Site {
+	enum { EMPTY = 0, CLAIMED, READY };
+
+	std::atomic<unsigned>	state;
+	const char*				file_name;
+	unsigned				line_number;
+	std::atomic<unsigned64>	failures;
+	std::atomic<unsigned64>	reported;
+	std::atomic<unsigned64>	dropped;
+	std::atomic<unsigned64>	window;			// second of the rate limit window
+	std::atomic<unsigned>	window_reports;	// reports in this window
+};
+
+// Open addressing, lock-free: a site is never removed.
+// Static storage, so all counters start as zeros.
+Site sites[SITE_TABLE_SIZE];
+
+// Collects the failures of all sites that did not fit into the table.
+Site other_sites;
+
+// Note: keys are the __FILE__ pointers, so the same header line seen
+// from two translation units could have two entries. Queries merge them.
+Site* FindSite(const char* file_name, unsigned line_number) {
+	size_t h = (reinterpret_cast<size_t>(file_name) >> 3) * 2654435761u + line_number;
+	for(unsigned probe=0; probe<SITE_TABLE_SIZE; ++probe) {
+		Site& site = sites[(h + probe) & (SITE_TABLE_SIZE - 1)];
+		unsigned state = site.state.load(std::memory_order_acquire);
+		if(state == Site::EMPTY) {
+			if(site.state.compare_exchange_strong(state, Site::CLAIMED,
+												   std::memory_order_acq_rel)) {
+				site.file_name = file_name;
+				site.line_number = line_number;
+				site.state.store(Site::READY, std::memory_order_release);
+				return &site;
+			}
+		}
+		while(state == Site::CLAIMED)
+			state = site.state.load(std::memory_order_acquire);
+		if(site.file_name == file_name && site.line_number == line_number)
+			return &site;
+	}
+	return &other_sites;
+}
+
+struct Record {
+	unsigned64	time_ns;
+	const char*	file_name;
+	unsigned	line_number;
+	char		message[MAX_MESSAGE];
+};
+
+// Ring buffer with one producer (the thread which has claimed it)
+// and one consumer (the drain thread).
+class Ring {
+  public:
+	Ring()
+	: head_(0), tail_(0), in_use(false), retired(false) {
+	}
+
+	// Returns false if the buffer is full.
+	bool Push(unsigned64 time_ns, const char* file_name,
+			  unsigned line_number, const char* message) {
+		unsigned64 head = head_.load(std::memory_order_relaxed);
+		if(head - tail_.load(std::memory_order_acquire) == RING_SIZE)
+			return false;
+		Record& r = records_[head % RING_SIZE];
+		r.time_ns = time_ns;
+		r.file_name = file_name;
+		r.line_number = line_number;
+		strncpy(r.message, message, MAX_MESSAGE - 1);
+		r.message[MAX_MESSAGE - 1] = '\0';
+		head_.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool Pop(Record& r) {
+		unsigned64 tail = tail_.load(std::memory_order_relaxed);
+		if(tail == head_.load(std::memory_order_acquire))
+			return false;
+		r = records_[tail % RING_SIZE];
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+  private:
+	std::atomic<unsigned64>	head_;
+	std::atomic<unsigned64>	tail_;
+	Record					records_[RING_SIZE];
+
+  public:
+	std::atomic<bool>	in_use;		// claimed by a thread
+	std::atomic<bool>	retired;	// the owner thread has exited
+};
+
+// Allocated by the first StartAsyncAssertLog() or
+// RegisterAsyncAssertLogThread() and never freed, so that no thread could
+// be left with a pointer to a deleted ring. A thread claims a ring when it
+// registers or on its first reported failure, the drain thread returns it
+// to the pool once the owner has exited and the ring has been emptied.
+Ring* RingPool() {
+	static Ring* pool = new Ring[MAX_THREADS];
+	return pool;
+}
+
+// Trivially destructible, so these stay valid while the other thread_local
+// objects are destroyed: their destructors could fail checks too.
+thread_local Ring*	this_thread_ring = NULL;
+thread_local bool	this_thread_exiting = false;
+
+// Hands the ring of the exiting thread over to the drain thread.
+// Later failures of the thread are counted as dropped.
+struct RingRelease {
+	~RingRelease() {
+		this_thread_exiting = true;
+		if(this_thread_ring != NULL) {
+			this_thread_ring->retired.store(true, std::memory_order_release);
+			this_thread_ring = NULL;
+		}
+	}
+};
+
+// Returns NULL if all rings are in use or the thread is exiting.
+// Once the thread has a ring, neither allocates memory nor takes locks.
+// Claiming the ring does: the runtime registers the destructor of
+// the thread_local RingRelease, hence RegisterAsyncAssertLogThread().
+Ring* ThisThreadRing() {
+	if(this_thread_ring != NULL || this_thread_exiting)
+		return this_thread_ring;
+
+	Ring* pool = RingPool();
+	for(unsigned i=0; i<MAX_THREADS; ++i) {
+		bool in_use = false;
+		if(pool[i].in_use.compare_exchange_strong(in_use, true,
+												  std::memory_order_acquire)) {
+			static thread_local RingRelease release;	// once per thread
+			(void)release;
+			this_thread_ring = &pool[i];
+			break;
+		}
+	}
+	return this_thread_ring;
+}
+
+std::atomic<unsigned>	max_reports_per_second(10);
+std::mutex				control_mutex;	// serializes Start and Stop
+SCPP_AssertHandlerFunc	previous_handler = NULL;	// guarded by control_mutex
+FILE*					log_file = NULL;			// guarded by control_mutex
+std::thread				drain_thread;
+std::mutex				drain_mutex;
+std::condition_variable	drain_cv;
+bool					stop_draining = false;	// guarded by drain_mutex
+
+void AsyncAssertHandler(const char* file_name,
+						unsigned line_number,
+						const char* message) {
+	Site* site = FindSite(file_name, line_number);
+	site->failures.fetch_add(1, std::memory_order_relaxed);
+
+	unsigned64 now = NowNanoseconds();
+	unsigned64 second = now / 1000000000;
+	unsigned64 window = site->window.load(std::memory_order_relaxed);
+	if(window != second
+		&& site->window.compare_exchange_strong(window, second, std::memory_order_relaxed))
+		site->window_reports.store(0, std::memory_order_relaxed);
+	if(site->window_reports.fetch_add(1, std::memory_order_relaxed)
+		>= max_reports_per_second.load(std::memory_order_relaxed))
+		return;
+
+	Ring* ring = ThisThreadRing();
+	if(ring != NULL && ring->Push(now, file_name, line_number, message))
+		site->reported.fetch_add(1, std::memory_order_relaxed);
+	else
+		site->dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void WriteRecord(const Record& r) {
+	time_t seconds = (time_t)(r.time_ns / 1000000000);
+	unsigned micros = (unsigned)(r.time_ns % 1000000000 / 1000);
+	struct tm t;
+#ifdef _WIN32
+	gmtime_s(&t, &seconds);
+#else
+	gmtime_r(&seconds, &t);
+#endif
+	fprintf(log_file, "%04d-%02d-%02d %02d:%02d:%02d.%06u UTC %s in file %s #%u\n",
+			t.tm_year + 1900, t.tm_mon + 1, t.tm_mday,
+			t.tm_hour, t.tm_min, t.tm_sec, micros,
+			r.message, r.file_name, r.line_number);
+}
+
+// Called by one thread at a time: the drain thread, or StopAsyncAssertLog()
+// after it has stopped. The failing threads never wait for it.
+void DrainAll() {
+	Ring* pool = RingPool();
+	for(unsigned i=0; i<MAX_THREADS; ++i) {
+		Ring& ring = pool[i];
+		if(!ring.in_use.load(std::memory_order_acquire))
+			continue;
+		// No reports are added after the owner has exited,
+		// so a retired ring is empty once drained.
+		bool retired = ring.retired.load(std::memory_order_acquire);
+		Record r;
+		while(ring.Pop(r))
+			WriteRecord(r);
+		if(retired) {
+			ring.retired.store(false, std::memory_order_relaxed);
+			ring.in_use.store(false, std::memory_order_release);
+		}
+	}
+	fflush(log_file);
+}
+
+void DrainLoop() {
+	std::unique_lock<std::mutex> lock(drain_mutex);
+	while(!stop_draining) {
+		drain_cv.wait_for(lock, std::chrono::milliseconds(50));
+		lock.unlock();
+		DrainAll();
+		lock.lock();
+	}
+}
+
+void AddStats(std::vector<AssertSiteStats>& stats, const char* file_name,
+			  unsigned line_number, const Site& site) {
+	for(size_t i=0; i<stats.size(); ++i) {
+		if(stats[i].line_number == line_number
+			&& strcmp(stats[i].file_name, file_name) == 0) {
+			stats[i].failures += site.failures.load(std::memory_order_relaxed);
+			stats[i].reported += site.reported.load(std::memory_order_relaxed);
+			stats[i].dropped += site.dropped.load(std::memory_order_relaxed);
+			return;
+		}
+	}
+	AssertSiteStats s;
+	s.file_name = file_name;
+	s.line_number = line_number;
+	s.failures = site.failures.load(std::memory_order_relaxed);
+	s.reported = site.reported.load(std::memory_order_relaxed);
+	s.dropped = site.dropped.load(std::memory_order_relaxed);
+	stats.push_back(s);
+}
+} // namespace
+
+bool StartAsyncAssertLog(const char* log_file_name,
+						 unsigned max_reports_per_site_per_second) {
+	SCPP_ASSERT(log_file_name != NULL, "StartAsyncAssertLog(): file name=0.");
+	std::lock_guard<std::mutex> control(control_mutex);
+	if(log_file != NULL)
+		return false;
+
+	log_file = fopen(log_file_name, "a");
+	if(log_file == NULL)
+		return false;
+
+	ThisThreadRing();
+	max_reports_per_second.store(max_reports_per_site_per_second);
+	stop_draining = false;
+	drain_thread = std::thread(DrainLoop);
+	previous_handler = SCPP_SetAssertHandler(AsyncAssertHandler);
+	return true;
+}
+
+void StopAsyncAssertLog() {
+	std::lock_guard<std::mutex> control(control_mutex);
+	if(log_file == NULL)
+		return;
+
+	SCPP_SetAssertHandler(previous_handler);
+	{
+		std::lock_guard<std::mutex> lock(drain_mutex);
+		stop_draining = true;
+	}
+	drain_cv.notify_one();
+	drain_thread.join();
+
+	DrainAll();
+	fclose(log_file);
+	log_file = NULL;
+}
+
+bool RegisterAsyncAssertLogThread() {
+	return ThisThreadRing() != NULL;
+}
+
+unsigned64 GetAssertFailureCount(const char* file_name, unsigned line_number) {
+	std::vector<AssertSiteStats> stats;
+	GetAssertSiteStats(stats);
+	for(size_t i=0; i<stats.size(); ++i)
+		if(stats[i].line_number == line_number && strcmp(stats[i].file_name, file_name) == 0)
+			return stats[i].failures;
+	return 0;
+}
+
+void GetAssertSiteStats(std::vector<AssertSiteStats>& stats) {
+	stats.clear();
+	for(unsigned i=0; i<SITE_TABLE_SIZE; ++i)
+		if(sites[i].state.load(std::memory_order_acquire) == Site::READY)
+			AddStats(stats, sites[i].file_name, sites[i].line_number, sites[i]);
+
+	if(other_sites.failures.load(std::memory_order_relaxed) != 0)
+		AddStats(stats, "<other sites>", 0, other_sites);
+}
+} // namespace scpp
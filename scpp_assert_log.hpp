@@ -0,0 +1,101 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#ifndef __SCPP_ASSERT_LOG_HPP_INCLUDED__
+#define __SCPP_ASSERT_LOG_HPP_INCLUDED__
+
+#include <vector>
+
+#include "scpp_assert.hpp"
+#include "scpp_types.hpp"
+
+/*
+	Non-fatal asynchronous reporting of failed sanity checks.
+	Features:
+		A failed check neither terminates the application nor throws:
+			the report is put into a lock-free ring buffer of the
+			current thread and the execution continues.
+		The ring buffers are allocated once, and a thread claims its
+			buffer by RegisterAsyncAssertLogThread() when it starts.
+			After that the failure path does not allocate memory nor
+			take locks. Up to 64 threads could have buffers at the same
+			time, the reports of further threads are counted as dropped.
+		A background thread drains the buffers of all threads
+			into a log file, so the failing thread never waits on I/O.
+		Failures are counted per check site (__FILE__, __LINE__),
+			and only a limited number of them per second is written
+			to the log, the rest is counted only.
+		The counters could be queried at run time.
+
+	Typical use:
+
+		int main() {
+			scpp::StartAsyncAssertLog("scpp_assert.log");
+			...
+			scpp::StopAsyncAssertLog();
+		}
+
+		void WorkerThread() {
+			scpp::RegisterAsyncAssertLogThread();
+			...
+		}
+
+	A thread which has not registered claims its buffer on the first
+	reported failure. That first failure does allocate: the C++ runtime
+	registers the thread exit handler which returns the buffer, e.g.
+	glibc calls calloc() and takes the loader lock in __cxa_thread_atexit.
+
+	Note that the code following a failed check is executed anyway,
+	e.g. an out-of-range index is used to access memory. This mode is
+	for services where one bad input must not stop the whole process.
+	Requires C++11 (threads and atomics).
+*/
+namespace scpp {
+
+// Installs the non-fatal handler and starts the background thread,
+// which appends the reports to the file log_file_name.
+// At most max_reports_per_site_per_second failures of one site are logged.
+// Returns false if the file could not be opened or the log is already running.
+// The calling thread is registered, see RegisterAsyncAssertLogThread().
+// StartAsyncAssertLog() and StopAsyncAssertLog() could be called from
+// any thread, they are serialized by a mutex.
+bool StartAsyncAssertLog(const char* log_file_name,
+						 unsigned max_reports_per_site_per_second = 10);
+
+// Writes all pending reports, stops the background thread,
+// and restores the error handler that was set before the start.
+void StopAsyncAssertLog();
+
+// Claims a ring buffer for the calling thread, so that its failures
+// are reported without allocating memory or taking locks. To be called
+// at the start of the thread, before or after StartAsyncAssertLog().
+// Returns false if all buffers are in use, the failures of the thread
+// are then counted as dropped. Calling it again does nothing.
+bool RegisterAsyncAssertLogThread();
+
+struct AssertSiteStats {
+	const char*	file_name;
+	unsigned	line_number;
+	unsigned64	failures;	// all failures of the site
+	unsigned64	reported;	// of them passed the rate limit
+	unsigned64	dropped;	// of them lost because no ring buffer had room
+};
+
+// Number of failures of the check site, 0 if it has never failed.
+unsigned64 GetAssertFailureCount(const char* file_name, unsigned line_number);
+
+// Statistics of all check sites that have failed so far.
+void GetAssertSiteStats(std::vector<AssertSiteStats>& stats);
+
+} // namespace scpp
+
+#endif // __SCPP_ASSERT_LOG_HPP_INCLUDED__
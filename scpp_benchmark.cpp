@@ -0,0 +1,1178 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "scpp_arena.hpp"
+#include "scpp_array.hpp"
+#include "scpp_assert.hpp"
+#include "scpp_assert_log.hpp"
+#include "scpp_bool_vector.hpp"
+#include "scpp_check_policy.hpp"
+#include "scpp_checked_math.hpp"
+#include "scpp_date.hpp"
+#include "scpp_decimal.hpp"
+#include "scpp_linalg.hpp"
+#include "scpp_matrix.hpp"
+#include "scpp_ptr.hpp"
+#include "scpp_range.hpp"
+#include "scpp_refcountptr.hpp"
+#include "scpp_scopedptr.hpp"
+#include "scpp_slotmap.hpp"
+#include "scpp_small_vector.hpp"
+#include "scpp_sort.hpp"
+#include "scpp_span.hpp"
+#include "scpp_tensor.hpp"
+#include "scpp_types.hpp"
+#include "scpp_vector.hpp"
+
+/*
+	Microbenchmarks of the scpp headers.
+	Features:
+		Each header has its typical workloads measured: vector scans,
+			matrix traversal orders, pointer copy and destroy, date
+			parse, format and decompose, etc. Where it makes sense the
+			same loop is run with NoCheck, DefaultCheck and AlwaysCheck,
+			and over a raw pointer, so that one run shows the cost
+			of the checks.
+		The same source is built twice, without and with _DEBUG,
+			to compare the unchecked build with the checked one
+			(DefaultCheck and SCPP_TEST_ASSERT are on in the latter).
+		Each benchmark is repeated until it runs for --min-time seconds,
+			the best of 3 such repetitions is reported in nanoseconds
+			per item (element, bit, pointer, date, etc.).
+		Results are written as JSON, and --compare reads two such files
+			and flags the benchmarks that became slower by more than
+			--threshold percent. The exit code is 1 if there are any.
+
+	Build (there is no makefile, all .cpp files of the library are needed):
+
+		g++ -std=c++11 -O2 -pthread -o scpp_benchmark scpp_benchmark.cpp \
+			scpp_arena.cpp scpp_assert.cpp scpp_assert_log.cpp scpp_bool_vector.cpp \
+			scpp_check_policy.cpp scpp_date.cpp scpp_instrument.cpp
+
+	and the same with -D_DEBUG -o scpp_benchmark_checked for the checked build.
+	Add -DSCPP_SAMPLED_CHECKS or -DSCPP_INSTRUMENT_CHECKS to measure these modes,
+	the build options are recorded in the JSON output.
+
+	Typical use:
+
+		./scpp_benchmark --json unchecked.json
+		./scpp_benchmark_checked --json checked.json
+		./scpp_benchmark --compare unchecked.json checked.json
+
+		./scpp_benchmark --filter matrix/ --min-time 0.5
+*/
+namespace {
+
+enum {
+	NUM_REPETITIONS = 3,
+
+	VECTOR_SIZE = 64*1024,			// ints, fits in L2 cache
+	ARRAY_SIZE = 4096,
+	MATRIX_SIZE = 1024,				// 8 MB of doubles, larger than L2
+	TRANSPOSE_SIZE = 2048,
+	LINALG_SIZE = 512,
+	BATCH_SIZE = 1000,				// objects created per call
+	BOOL_VECTOR_SIZE = 1024*1024,	// bits
+	TENSOR_SIZE = 64,
+	SORT_SIZE = 1024*1024,
+	NUM_LOOKUPS = 4096
+};
+
+// Makes the compiler assume that x is used,
+// so that the computation of x is not optimized away.
+template <typename T>
+inline void KeepValue(const T& x) {
+	asm volatile("" : : "r"(&x) : "memory");
+}
+
+struct Result {
+	std::string	name;
+	double		ns_per_item;
+	unsigned64	items;			// per call of the benchmark function
+	double		gflops;			// 0 if not applicable
+	double		residual;		// accuracy of a solver, 0 if not applicable
+};
+
+struct Options {
+	double		min_time;		// seconds per repetition
+	std::string	filter;			// prefix of benchmark names to run
+	std::string	json_file;		// "-" for stdout, empty for none
+
+	Options()
+	: min_time(0.05) {
+	}
+};
+
+class Runner {
+  public:
+	explicit Runner(const Options& options)
+	: options_(options) {
+	}
+
+	// True if some benchmarks with the name starting with prefix are to be run,
+	// used to skip the preparation of the data.
+	bool Wanted(const std::string& prefix) const {
+		size_t n = std::min(prefix.size(), options_.filter.size());
+		return options_.filter.compare(0, n, prefix, 0, n) == 0;
+	}
+
+	// Measures f(), which processes items items per call and,
+	// if flops is not 0, performs flops floating-point operations.
+	template <typename F>
+	void Run(const std::string& name, unsigned64 items, F f,
+			 double flops = 0, double residual = 0) {
+		if(name.compare(0, options_.filter.size(), options_.filter) != 0)
+			return;
+
+		f();	// warm up the caches and the branch predictor
+
+		unsigned64 calls = 1;
+		double seconds = TimeCalls(f, calls);
+		while(seconds < options_.min_time) {
+			double factor = seconds > 0 ? 1.2 * options_.min_time / seconds : 100;
+			factor = std::max(2.0, std::min(100.0, factor));
+			calls = unsigned64(calls * factor);
+			seconds = TimeCalls(f, calls);
+		}
+		for(unsigned rep=1; rep<NUM_REPETITIONS; ++rep)
+			seconds = std::min(seconds, TimeCalls(f, calls));
+
+		Result result;
+		result.name = name;
+		result.ns_per_item = seconds * 1e9 / (double(calls) * double(items));
+		result.items = items;
+		result.gflops = flops != 0 ? flops * double(calls) / seconds * 1e-9 : 0;
+		result.residual = residual;
+		results_.push_back(result);
+
+		printf("%-44s %14.3f ns/item", name.c_str(), result.ns_per_item);
+		if(result.gflops != 0)
+			printf(" %8.2f GFLOP/s", result.gflops);
+		if(result.residual != 0)
+			printf("   residual %.2e", result.residual);
+		printf("\n");
+		fflush(stdout);
+	}
+
+	const std::vector<Result>& Results() const { return results_; }
+
+  private:
+	const Options&		options_;
+	std::vector<Result>	results_;
+
+	template <typename F>
+	static double TimeCalls(F& f, unsigned64 calls) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for(unsigned64 i=0; i<calls; ++i)
+			f();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+};
+
+// All random data is generated from a fixed seed,
+// so that two runs measure the same work.
+std::mt19937_64& RandomGenerator() {
+	static std::mt19937_64 generator(20120901);
+	return generator;
+}
+
+// Random integer in [lo, hi].
+int64 RandomInt(int64 lo, int64 hi) {
+	return std::uniform_int_distribution<int64>(lo, hi)(RandomGenerator());
+}
+
+double RandomDouble() {
+	return std::uniform_real_distribution<double>(-1, 1)(RandomGenerator());
+}
+
+// ----------------------------------------------------------------------------
+// scpp_vector.hpp, scpp_array.hpp, scpp_span.hpp, scpp_range.hpp, scpp_check_policy.hpp
+
+template <typename Container>
+int64 SumByIndex(const Container& c, unsigned64 size) {
+	int64 sum = 0;
+	for(unsigned64 i=0; i<size; ++i)
+		sum += c[i];
+	return sum;
+}
+
+template <typename Check>
+void RunVectorScan(Runner& runner, const std::string& name, const std::vector<int>& data) {
+	scpp::vector<int, std::allocator<int>, Check> v(data.begin(), data.end());
+	runner.Run(name, v.size(), [&v]() { KeepValue(SumByIndex(v, v.size())); });
+}
+
+void BenchVector(Runner& runner) {
+	if(!runner.Wanted("vector/") && !runner.Wanted("check_policy/") && !runner.Wanted("range/"))
+		return;
+
+	std::vector<int> data(VECTOR_SIZE);
+	for(unsigned i=0; i<data.size(); ++i)
+		data[i] = int(RandomInt(0, 1000));
+
+	runner.Run("vector/scan_raw_pointer", data.size(), [&data]() {
+		KeepValue(SumByIndex(&data[0], data.size()));
+	});
+	RunVectorScan<scpp::NoCheck>(runner, "vector/scan_nocheck", data);
+	RunVectorScan<scpp::DefaultCheck>(runner, "vector/scan_default", data);
+	RunVectorScan<scpp::AlwaysCheck>(runner, "vector/scan_alwayscheck", data);
+
+	scpp::vector<int> v(data.begin(), data.end());
+	runner.Run("vector/scale_default", v.size(), [&v]() {
+		for(unsigned64 i=0; i<v.size(); ++i)
+			v[i] = v[i] * 3 + 1;
+		KeepValue(v[0]);
+	});
+
+	// The overhead of sampled checks as a function of the sampling period.
+	RunVectorScan<scpp::Sampled<1> >(runner, "check_policy/scan_sampled_1", data);
+	RunVectorScan<scpp::Sampled<10> >(runner, "check_policy/scan_sampled_10", data);
+	RunVectorScan<scpp::Sampled<100> >(runner, "check_policy/scan_sampled_100", data);
+	RunVectorScan<scpp::Sampled<1000> >(runner, "check_policy/scan_sampled_1000", data);
+	unsigned period = scpp::GetCheckSamplingPeriod();
+	scpp::SetCheckSamplingPeriod(100);
+	RunVectorScan<scpp::RuntimeSampled>(runner, "check_policy/scan_runtime_sampled_100", data);
+	scpp::SetCheckSamplingPeriod(period);
+
+	// The same loops with the range checked once, vs vector/scan_default
+	// and vector/scale_default.
+	runner.Run("range/for_each_index_scan", v.size(), [&v]() {
+		int64 sum = 0;
+		scpp::for_each_index(v, 0, v.size(), [&sum](unsigned64, int x) { sum += x; });
+		KeepValue(sum);
+	});
+	runner.Run("range/checked_range_scan", v.size(), [&v]() {
+		scpp::checked_range<const int> r = scpp::make_checked_range(
+			static_cast<const scpp::vector<int>&>(v), 0, v.size());
+		int64 sum = 0;
+		for(unsigned64 i=r.lo(); i<r.hi(); ++i)
+			sum += r[i];
+		KeepValue(sum);
+	});
+	runner.Run("range/for_each_index_scale", v.size(), [&v]() {
+		scpp::for_each_index(v, 0, v.size(), [](unsigned64, int& x) { x = x * 3 + 1; });
+		KeepValue(v[0]);
+	});
+}
+
+template <typename Check>
+void RunArrayScan(Runner& runner, const std::string& name) {
+	scpp::ScopedPtr<scpp::array<int, ARRAY_SIZE, Check> > a(
+		new scpp::array<int, ARRAY_SIZE, Check>(0));
+	for(unsigned i=0; i<ARRAY_SIZE; ++i)
+		(*a)[i] = int(RandomInt(0, 1000));
+	const scpp::array<int, ARRAY_SIZE, Check>& ref = *a;
+	runner.Run(name, ARRAY_SIZE, [&ref]() { KeepValue(SumByIndex(ref, ARRAY_SIZE)); });
+}
+
+void BenchArrayAndSpan(Runner& runner) {
+	RunArrayScan<scpp::NoCheck>(runner, "array/scan_nocheck");
+	RunArrayScan<scpp::DefaultCheck>(runner, "array/scan_default");
+
+	if(!runner.Wanted("span/"))
+		return;
+	scpp::vector<int> v(VECTOR_SIZE);
+	for(unsigned64 i=0; i<v.size(); ++i)
+		v[i] = int(RandomInt(0, 1000));
+	scpp::span<const int> s(static_cast<const scpp::vector<int>&>(v));
+	runner.Run("span/scan_default", s.size(), [&s]() { KeepValue(SumByIndex(s, s.size())); });
+	runner.Run("span/scan_checked_range", s.size(), [&s]() {
+		int64 sum = 0;
+		scpp::for_each_index(s, 0, s.size(), [&sum](unsigned64, int x) { sum += x; });
+		KeepValue(sum);
+	});
+}
+
+// ----------------------------------------------------------------------------
+// scpp_matrix.hpp
+
+template <typename M>
+double SumByRows(const M& m) {
+	double sum = 0;
+	for(typename M::size_type r=0; r<m.num_rows(); ++r)
+		for(typename M::size_type c=0; c<m.num_cols(); ++c)
+			sum += m(r, c);
+	return sum;
+}
+
+template <typename M>
+double SumByCols(const M& m) {
+	double sum = 0;
+	for(typename M::size_type c=0; c<m.num_cols(); ++c)
+		for(typename M::size_type r=0; r<m.num_rows(); ++r)
+			sum += m(r, c);
+	return sum;
+}
+
+template <typename M>
+void FillRandom(M& m) {
+	for(typename M::size_type r=0; r<m.num_rows(); ++r)
+		for(typename M::size_type c=0; c<m.num_cols(); ++c)
+			m(r, c) = RandomDouble();
+}
+
+template <typename Check, typename Layout>
+void RunMatrixTraversal(Runner& runner, const std::string& name) {
+	if(!runner.Wanted(name))
+		return;
+	scpp::matrix<double, std::allocator<double>, Check, Layout> m(MATRIX_SIZE, MATRIX_SIZE);
+	FillRandom(m);
+	const unsigned64 n = MATRIX_SIZE * MATRIX_SIZE;
+	runner.Run(name + "_by_rows", n, [&m]() { KeepValue(SumByRows(m)); });
+	runner.Run(name + "_by_cols", n, [&m]() { KeepValue(SumByCols(m)); });
+}
+
+// Index arithmetic of a raw row-major array with 32- and 64-bit indices,
+// vs m(r, c) of scpp::matrix, which uses 64-bit size_type.
+template <typename Index>
+double SumRawIndex(const double* data, Index num_rows, Index num_cols) {
+	double sum = 0;
+	for(Index r=0; r<num_rows; ++r)
+		for(Index c=0; c<num_cols; ++c)
+			sum += data[r * num_cols + c];
+	return sum;
+}
+
+void BenchMatrix(Runner& runner) {
+	RunMatrixTraversal<scpp::DefaultCheck, scpp::RowMajor>(runner, "matrix/sum_row_major");
+	RunMatrixTraversal<scpp::DefaultCheck, scpp::ColMajor>(runner, "matrix/sum_col_major");
+	RunMatrixTraversal<scpp::NoCheck, scpp::RowMajor>(runner, "matrix/sum_row_major_nocheck");
+
+	if(runner.Wanted("matrix/sum_")) {
+		scpp::matrix<double> m(MATRIX_SIZE, MATRIX_SIZE);
+		FillRandom(m);
+		const unsigned64 n = MATRIX_SIZE * MATRIX_SIZE;
+		const double* data = m.data();
+		runner.Run("matrix/sum_raw_index32", n, [data]() {
+			KeepValue(SumRawIndex<unsigned>(data, MATRIX_SIZE, MATRIX_SIZE));
+		});
+		runner.Run("matrix/sum_raw_index64", n, [data]() {
+			KeepValue(SumRawIndex<unsigned64>(data, MATRIX_SIZE, MATRIX_SIZE));
+		});
+		runner.Run("matrix/sum_row_data", n, [&m]() {
+			double sum = 0;
+			for(unsigned64 r=0; r<m.num_rows(); ++r) {
+				const double* row = m.row_data(r);
+				for(unsigned64 c=0; c<m.num_cols(); ++c)
+					sum += row[c];
+			}
+			KeepValue(sum);
+		});
+		runner.Run("matrix/sum_for_each_index", n, [&m]() {
+			double sum = 0;
+			scpp::for_each_index(m, 0, m.num_rows(), 0, m.num_cols(),
+				[&sum](unsigned64, unsigned64, double x) { sum += x; });
+			KeepValue(sum);
+		});
+	}
+
+	if(!runner.Wanted("matrix/transpose") && !runner.Wanted("matrix/convert_layout"))
+		return;
+	scpp::matrix<double, std::allocator<double>, scpp::NoCheck> src(TRANSPOSE_SIZE, TRANSPOSE_SIZE);
+	scpp::matrix<double, std::allocator<double>, scpp::NoCheck> dst(TRANSPOSE_SIZE, TRANSPOSE_SIZE);
+	FillRandom(src);
+	const unsigned64 n = TRANSPOSE_SIZE * TRANSPOSE_SIZE;
+	runner.Run("matrix/transpose_naive", n, [&src, &dst]() {
+		for(unsigned64 r=0; r<src.num_rows(); ++r)
+			for(unsigned64 c=0; c<src.num_cols(); ++c)
+				dst(c, r) = src(r, c);
+		KeepValue(dst(0, 0));
+	});
+	runner.Run("matrix/transpose_blocked", n, [&src, &dst]() {
+		scpp::transpose(src, dst);
+		KeepValue(dst(0, 0));
+	});
+	runner.Run("matrix/transpose_in_place", n, [&dst]() {
+		dst.transpose();
+		KeepValue(dst(0, 0));
+	});
+	scpp::matrix<double, std::allocator<double>, scpp::NoCheck, scpp::ColMajor>
+		col_major(TRANSPOSE_SIZE, TRANSPOSE_SIZE);
+	runner.Run("matrix/convert_layout", n, [&src, &col_major]() {
+		scpp::convert_layout(src, col_major);
+		KeepValue(col_major(0, 0));
+	});
+}
+
+// ----------------------------------------------------------------------------
+// scpp_linalg.hpp
+
+typedef scpp::matrix<double> Matrix;
+
+// max |a x - b| / (max |a| * max |x|), of the order of 1e-16 .. 1e-13
+// for a stable solver in double precision.
+double Residual(const Matrix& a, const Matrix& x, const Matrix& b) {
+	double max_a = 0, max_x = 0, max_r = 0;
+	for(unsigned64 i=0; i<a.num_rows(); ++i) {
+		double ax = 0;
+		for(unsigned64 j=0; j<a.num_cols(); ++j) {
+			ax += a(i, j) * x(j, 0);
+			max_a = std::max(max_a, fabs(a(i, j)));
+		}
+		max_x = std::max(max_x, fabs(x(i, 0)));
+		max_r = std::max(max_r, fabs(ax - b(i, 0)));
+	}
+	return max_r / (max_a * max_x);
+}
+
+void BenchLinalg(Runner& runner) {
+	if(!runner.Wanted("linalg/"))
+		return;
+
+	// Symmetric and diagonally dominant, so both LU and Cholesky work.
+	const unsigned64 n = LINALG_SIZE;
+	Matrix a(n, n);
+	for(unsigned64 i=0; i<n; ++i) {
+		for(unsigned64 j=0; j<i; ++j)
+			a(i, j) = a(j, i) = RandomDouble();
+		a(i, i) = double(n);
+	}
+	Matrix b(n, 1);
+	FillRandom(b);
+
+	Matrix lu(a);
+	std::vector<unsigned64> pivots;
+	scpp::lu_factorize(lu, pivots);
+	Matrix x(b);
+	scpp::lu_solve(lu, pivots, x);
+	runner.Run("linalg/lu_factorize", 1, [&a, &lu, &pivots]() {
+		lu = a;
+		KeepValue(scpp::lu_factorize(lu, pivots));
+	}, 2.0 / 3 * n * n * n, Residual(a, x, b));
+	runner.Run("linalg/lu_solve", 1, [&lu, &pivots, &b, &x]() {
+		x = b;
+		scpp::lu_solve(lu, pivots, x);
+		KeepValue(x(0, 0));
+	}, 2.0 * n * n);
+
+	Matrix l(a);
+	scpp::cholesky_factorize(l);
+	x = b;
+	scpp::cholesky_solve(l, x);
+	runner.Run("linalg/cholesky_factorize", 1, [&a, &l]() {
+		l = a;
+		KeepValue(scpp::cholesky_factorize(l));
+	}, 1.0 / 3 * n * n * n, Residual(a, x, b));
+
+	// The trailing update split between threads, at least two of them
+	// so that the threaded path is exercised on any machine.
+	const unsigned threads = std::max(2u, std::thread::hardware_concurrency());
+	lu = a;
+	scpp::lu_factorize(lu, pivots, threads);
+	x = b;
+	scpp::lu_solve(lu, pivots, x, threads);
+	runner.Run("linalg/lu_factorize_threads", 1, [&a, &lu, &pivots, threads]() {
+		lu = a;
+		KeepValue(scpp::lu_factorize(lu, pivots, threads));
+	}, 2.0 / 3 * n * n * n, Residual(a, x, b));
+
+	l = a;
+	scpp::cholesky_factorize(l, threads);
+	x = b;
+	scpp::cholesky_solve(l, x, threads);
+	runner.Run("linalg/cholesky_factorize_threads", 1, [&a, &l, threads]() {
+		l = a;
+		KeepValue(scpp::cholesky_factorize(l, threads));
+	}, 1.0 / 3 * n * n * n, Residual(a, x, b));
+}
+
+// ----------------------------------------------------------------------------
+// scpp_ptr.hpp, scpp_refcountptr.hpp, scpp_scopedptr.hpp
+
+template <typename Check>
+void RunPtrDeref(Runner& runner, const std::string& name, std::vector<int>& objects) {
+	std::vector<scpp::Ptr<int, Check> > ptrs(objects.size());
+	for(unsigned i=0; i<objects.size(); ++i)
+		ptrs[i] = &objects[i];
+	runner.Run(name, ptrs.size(), [&ptrs]() {
+		int64 sum = 0;
+		for(unsigned i=0; i<ptrs.size(); ++i)
+			sum += *ptrs[i];
+		KeepValue(sum);
+	});
+}
+
+void BenchPointers(Runner& runner) {
+	runner.Run("ptr/raw_new_delete", BATCH_SIZE, []() {
+		for(int i=0; i<BATCH_SIZE; ++i) {
+			int* p = new int(i);
+			KeepValue(p);
+			delete p;
+		}
+	});
+	runner.Run("ptr/scopedptr_create_destroy", BATCH_SIZE, []() {
+		for(int i=0; i<BATCH_SIZE; ++i) {
+			scpp::ScopedPtr<int> p(new int(i));
+			KeepValue(*p);
+		}
+	});
+	runner.Run("ptr/refcountptr_create_destroy", BATCH_SIZE, []() {
+		for(int i=0; i<BATCH_SIZE; ++i) {
+			scpp::RefCountPtr<int> p(new int(i));
+			KeepValue(*p);
+		}
+	});
+
+	scpp::RefCountPtr<int> shared(new int(1));
+	runner.Run("ptr/refcountptr_copy_destroy", BATCH_SIZE, [&shared]() {
+		for(int i=0; i<BATCH_SIZE; ++i) {
+			scpp::RefCountPtr<int> copy(shared);
+			KeepValue(*copy);
+		}
+	});
+	std::vector<scpp::RefCountPtr<int> > copies(BATCH_SIZE);
+	runner.Run("ptr/refcountptr_assign", BATCH_SIZE, [&shared, &copies]() {
+		for(unsigned i=0; i<copies.size(); ++i)
+			copies[i] = shared;
+		for(unsigned i=0; i<copies.size(); ++i)
+			copies[i] = NULL;
+	});
+
+	std::vector<int> objects(VECTOR_SIZE);
+	for(unsigned i=0; i<objects.size(); ++i)
+		objects[i] = int(i);
+	RunPtrDeref<scpp::NoCheck>(runner, "ptr/deref_nocheck", objects);
+	RunPtrDeref<scpp::DefaultCheck>(runner, "ptr/deref_default", objects);
+}
+
+// ----------------------------------------------------------------------------
+// scpp_date.hpp
+
+void BenchDate(Runner& runner) {
+	if(!runner.Wanted("date/"))
+		return;
+
+	std::vector<scpp::Date> dates(BATCH_SIZE);
+	std::vector<std::string> strings(BATCH_SIZE);
+	for(unsigned i=0; i<dates.size(); ++i) {
+		dates[i] = scpp::Date(1950, 1, 1) + int(RandomInt(0, 100*365));
+		strings[i] = dates[i].AsString();
+	}
+
+	runner.Run("date/parse", dates.size(), [&strings]() {
+		for(unsigned i=0; i<strings.size(); ++i) {
+			scpp::Date d(strings[i].c_str());
+			KeepValue(d);
+		}
+	});
+	runner.Run("date/format", dates.size(), [&dates]() {
+		char buffer[scpp::Date::MIN_BUFFER_SIZE];
+		for(unsigned i=0; i<dates.size(); ++i)
+			KeepValue(dates[i].AsString(buffer, sizeof buffer)[0]);
+	});
+	runner.Run("date/format_string", dates.size(), [&dates]() {
+		for(unsigned i=0; i<dates.size(); ++i)
+			KeepValue(dates[i].AsString());
+	});
+	runner.Run("date/decompose", dates.size(), [&dates]() {
+		unsigned sum = 0;
+		for(unsigned i=0; i<dates.size(); ++i)
+			sum += dates[i].Year() + dates[i].Month() + dates[i].DayOfMonth();
+		KeepValue(sum);
+	});
+	runner.Run("date/as_yyyymmdd", dates.size(), [&dates]() {
+		unsigned sum = 0;
+		for(unsigned i=0; i<dates.size(); ++i)
+			sum += dates[i].AsYYYYMMDD();
+		KeepValue(sum);
+	});
+	runner.Run("date/day_of_week", dates.size(), [&dates]() {
+		unsigned sum = 0;
+		for(unsigned i=0; i<dates.size(); ++i)
+			sum += dates[i].DayOfWeek();
+		KeepValue(sum);
+	});
+	runner.Run("date/increment", dates.size(), [&dates]() {
+		scpp::Date d = dates[0];
+		for(unsigned i=0; i<dates.size(); ++i) {
+			++d;
+			KeepValue(d);
+		}
+	});
+}
+
+// ----------------------------------------------------------------------------
+// scpp_types.hpp, scpp_checked_math.hpp
+
+template <typename T>
+void RunAccumulate(Runner& runner, const std::string& name, const std::vector<int>& data) {
+	std::vector<T> values(data.begin(), data.end());
+	runner.Run(name, values.size(), [&values]() {
+		T sum = 0;
+		for(unsigned i=0; i<values.size(); ++i)
+			sum += values[i];
+		KeepValue(sum);
+	});
+}
+
+void BenchArithmetic(Runner& runner) {
+	if(!runner.Wanted("types/") && !runner.Wanted("checked_math/"))
+		return;
+
+	std::vector<int> data(VECTOR_SIZE);
+	for(unsigned i=0; i<data.size(); ++i)
+		data[i] = int(RandomInt(0, 1000));
+	RunAccumulate<int>(runner, "types/accumulate_int", data);
+	RunAccumulate<Int>(runner, "types/accumulate_wrapping", data);
+	RunAccumulate<CheckedInt>(runner, "types/accumulate_checked", data);
+	RunAccumulate<SaturatingInt>(runner, "types/accumulate_saturating", data);
+
+	// Element-wise addition of arrays: unchecked, checked per element,
+	// and checked once per block of elements.
+	std::vector<int64> a(VECTOR_SIZE), b(VECTOR_SIZE), c(VECTOR_SIZE);
+	for(unsigned i=0; i<a.size(); ++i) {
+		a[i] = RandomInt(-1000000, 1000000);
+		b[i] = RandomInt(-1000000, 1000000);
+	}
+	runner.Run("checked_math/add_unchecked", a.size(), [&a, &b, &c]() {
+		for(unsigned i=0; i<a.size(); ++i)
+			c[i] = a[i] + b[i];
+		KeepValue(c[0]);
+	});
+	runner.Run("checked_math/add_per_element", a.size(), [&a, &b, &c]() {
+		for(unsigned i=0; i<a.size(); ++i)
+			SCPP_ASSERT(!__builtin_add_overflow(a[i], b[i], &c[i]),
+				"Overflow in " << a[i] << " + " << b[i]);
+		KeepValue(c[0]);
+	});
+	runner.Run("checked_math/add_arrays", a.size(), [&a, &b, &c]() {
+		KeepValue(scpp::AddArrays(&a[0], &b[0], &c[0], a.size()));
+	});
+	runner.Run("checked_math/mul_arrays", a.size(), [&a, &b, &c]() {
+		KeepValue(scpp::MulArrays(&a[0], &b[0], &c[0], a.size()));
+	});
+	runner.Run("checked_math/sum_array", a.size(), [&a]() {
+		int64 sum = 0;
+		KeepValue(scpp::SumArray(&a[0], a.size(), sum));
+		KeepValue(sum);
+	});
+}
+
+// ----------------------------------------------------------------------------
+// scpp_decimal.hpp
+
+void BenchDecimal(Runner& runner) {
+	if(!runner.Wanted("decimal/"))
+		return;
+
+	typedef scpp::Decimal<4> Money;
+	std::vector<Money> values(BATCH_SIZE);
+	std::vector<std::string> strings(BATCH_SIZE);
+	for(unsigned i=0; i<values.size(); ++i) {
+		values[i] = Money::FromUnits(RandomInt(-100000000, 100000000));
+		char buffer[Money::MAX_CHARS];
+		strings[i].assign(buffer, scpp::ToChars(buffer, buffer + sizeof buffer, values[i]));
+	}
+
+	runner.Run("decimal/parse", values.size(), [&strings]() {
+		Money x;
+		for(unsigned i=0; i<strings.size(); ++i) {
+			const std::string& s = strings[i];
+			KeepValue(scpp::FromChars(s.data(), s.data() + s.size(), x));
+		}
+		KeepValue(x);
+	});
+	runner.Run("decimal/format", values.size(), [&values]() {
+		char buffer[Money::MAX_CHARS];
+		for(unsigned i=0; i<values.size(); ++i)
+			KeepValue(scpp::ToChars(buffer, buffer + sizeof buffer, values[i]));
+	});
+	runner.Run("decimal/add", values.size(), [&values]() {
+		Money sum;
+		for(unsigned i=0; i<values.size(); ++i)
+			sum += values[i];
+		KeepValue(sum);
+	});
+	const Money rate = Money::FromDouble(1.0375);
+	runner.Run("decimal/mul", values.size(), [&values, &rate]() {
+		for(unsigned i=0; i<values.size(); ++i)
+			KeepValue(values[i].Mul(rate, scpp::ROUND_HALF_EVEN));
+	});
+	runner.Run("decimal/div", values.size(), [&values, &rate]() {
+		for(unsigned i=0; i<values.size(); ++i)
+			KeepValue(values[i].Div(rate, scpp::ROUND_HALF_EVEN));
+	});
+}
+
+// ----------------------------------------------------------------------------
+// scpp_bool_vector.hpp
+
+void BenchBoolVector(Runner& runner) {
+	if(!runner.Wanted("bool_vector/"))
+		return;
+
+	// One bit in 16 is set on average.
+	scpp::BoolVector x(BOOL_VECTOR_SIZE), y(BOOL_VECTOR_SIZE, true);
+	std::vector<unsigned char> bytes_x(BOOL_VECTOR_SIZE), bytes_y(BOOL_VECTOR_SIZE, 1);
+	for(unsigned i=0; i<BOOL_VECTOR_SIZE; ++i) {
+		if(RandomInt(0, 15) == 0) {
+			x[i] = true;
+			bytes_x[i] = 1;
+		}
+	}
+
+	runner.Run("bool_vector/and", BOOL_VECTOR_SIZE, [&x, &y]() {
+		y &= x;
+		KeepValue(y.words()[0]);
+	});
+	runner.Run("bool_vector/and_bytes", BOOL_VECTOR_SIZE, [&bytes_x, &bytes_y]() {
+		for(unsigned i=0; i<bytes_x.size(); ++i)
+			bytes_y[i] &= bytes_x[i];
+		KeepValue(bytes_y[0]);
+	});
+	runner.Run("bool_vector/count", BOOL_VECTOR_SIZE, [&x]() {
+		KeepValue(x.count());
+	});
+	runner.Run("bool_vector/find_next", BOOL_VECTOR_SIZE, [&x]() {
+		unsigned64 sum = 0;
+		for(unsigned64 i=x.find_first(); i!=scpp::BoolVector::npos; i=x.find_next(i))
+			sum += i;
+		KeepValue(sum);
+	});
+	const scpp::BoolVector& cx = x;
+	runner.Run("bool_vector/index_default", BOOL_VECTOR_SIZE, [&cx]() {
+		unsigned64 n = 0;
+		for(unsigned64 i=0; i<cx.size(); ++i)
+			n += cx[i];
+		KeepValue(n);
+	});
+}
+
+// ----------------------------------------------------------------------------
+// scpp_small_vector.hpp, scpp_arena.hpp, scpp_slotmap.hpp
+
+void BenchAllocation(Runner& runner) {
+	enum { SMALL_SIZE = 8 };
+	runner.Run("small_vector/push_back_inline", BATCH_SIZE * SMALL_SIZE, []() {
+		for(int i=0; i<BATCH_SIZE; ++i) {
+			scpp::small_vector<int, SMALL_SIZE> v;
+			for(int k=0; k<SMALL_SIZE; ++k)
+				v.push_back(k);
+			KeepValue(v[SMALL_SIZE - 1]);
+		}
+	});
+	runner.Run("small_vector/std_vector_push_back", BATCH_SIZE * SMALL_SIZE, []() {
+		for(int i=0; i<BATCH_SIZE; ++i) {
+			std::vector<int> v;
+			for(int k=0; k<SMALL_SIZE; ++k)
+				v.push_back(k);
+			KeepValue(v[SMALL_SIZE - 1]);
+		}
+	});
+
+	scpp::Arena arena;
+	runner.Run("arena/vector_create_destroy", BATCH_SIZE, [&arena]() {
+		scpp::ArenaScope scope(arena);
+		scpp::ArenaAllocator<double> alloc(arena);
+		for(int i=0; i<BATCH_SIZE; ++i) {
+			scpp::vector<double, scpp::ArenaAllocator<double> > v(16, alloc);
+			KeepValue(v[0]);
+		}
+	});
+	runner.Run("arena/heap_vector_create_destroy", BATCH_SIZE, []() {
+		for(int i=0; i<BATCH_SIZE; ++i) {
+			scpp::vector<double> v(16);
+			KeepValue(v[0]);
+		}
+	});
+
+	if(!runner.Wanted("slotmap/"))
+		return;
+	scpp::SlotMap<int> map;
+	std::vector<scpp::Handle<int> > handles(BATCH_SIZE);
+	runner.Run("slotmap/insert_erase", BATCH_SIZE, [&map, &handles]() {
+		for(unsigned i=0; i<handles.size(); ++i)
+			handles[i] = map.Insert(int(i));
+		for(unsigned i=0; i<handles.size(); ++i)
+			map.Erase(handles[i]);
+	});
+
+	for(unsigned i=0; i<VECTOR_SIZE; ++i)
+		map.Insert(int(i));
+	std::vector<scpp::Handle<int> > lookups(NUM_LOOKUPS);
+	for(unsigned i=0; i<lookups.size(); ++i)
+		lookups[i] = map.HandleAt(RandomInt(0, map.Size() - 1));
+	runner.Run("slotmap/lookup", lookups.size(), [&map, &lookups]() {
+		int64 sum = 0;
+		for(unsigned i=0; i<lookups.size(); ++i)
+			sum += map[lookups[i]];
+		KeepValue(sum);
+	});
+	runner.Run("slotmap/iterate", map.Size(), [&map]() {
+		int64 sum = 0;
+		for(scpp::SlotMap<int>::const_iterator p=map.begin(); p!=map.end(); ++p)
+			sum += *p;
+		KeepValue(sum);
+	});
+}
+
+// ----------------------------------------------------------------------------
+// scpp_tensor.hpp
+
+void BenchTensor(Runner& runner) {
+	if(!runner.Wanted("tensor/"))
+		return;
+
+	typedef scpp::tensor<double, 3> Tensor;
+	const Tensor::size_type shape[3] = { TENSOR_SIZE, TENSOR_SIZE, TENSOR_SIZE };
+	const Tensor::size_type plane[2] = { TENSOR_SIZE, TENSOR_SIZE };
+	Tensor a(shape), b(shape), c(shape);
+	scpp::tensor<double, 2> sums(plane);
+	scpp::for_each_element([](double& x) { x = RandomDouble(); }, a.view());
+	scpp::for_each_element([](double& x) { x = RandomDouble(); }, b.view());
+	const unsigned64 n = a.size();
+
+	runner.Run("tensor/transform_contiguous", n, [&a, &b, &c]() {
+		scpp::transform(c.view(), [](double x, double y) { return x + y; }, a.view(), b.view());
+		KeepValue(c(0, 0, 0));
+	});
+	runner.Run("tensor/transform_permuted", n, [&a, &b, &c]() {
+		scpp::transform(c.view(), [](double x, double y) { return x + y; },
+						a.view().permute(2, 1, 0), b.view());
+		KeepValue(c(0, 0, 0));
+	});
+	for(unsigned axis=0; axis<3; ++axis) {
+		char name[32];
+		sprintf(name, "tensor/reduce_axis%u", axis);
+		runner.Run(name, n, [&a, &sums, axis]() {
+			scpp::reduce(a.view(), axis, sums.view(), 0.0, std::plus<double>());
+			KeepValue(sums(0, 0));
+		});
+	}
+	runner.Run("tensor/reduce_all", n, [&a]() {
+		KeepValue(scpp::reduce_all(a.view(), 0.0, std::plus<double>()));
+	});
+}
+
+// ----------------------------------------------------------------------------
+// scpp_sort.hpp
+
+void BenchSort(Runner& runner) {
+	if(!runner.Wanted("sort/"))
+		return;
+
+	// Both sorts include the copy of the input.
+	scpp::vector<int64> data(SORT_SIZE), v(SORT_SIZE);
+	for(unsigned64 i=0; i<data.size(); ++i)
+		data[i] = RandomInt(-1000000000000LL, 1000000000000LL);
+	runner.Run("sort/radix_sort_int64", data.size(), [&data, &v]() {
+		v = data;
+		scpp::radix_sort(v);
+		KeepValue(v[0]);
+	});
+	runner.Run("sort/std_sort_int64", data.size(), [&data, &v]() {
+		v = data;
+		std::sort(v.begin(), v.end());
+		KeepValue(v[0]);
+	});
+
+	scpp::vector<scpp::Date> dates(SORT_SIZE), sorted_dates(SORT_SIZE);
+	for(unsigned64 i=0; i<dates.size(); ++i)
+		dates[i] = scpp::Date(1950, 1, 1) + int(RandomInt(0, 100*365));
+	runner.Run("sort/radix_sort_date", dates.size(), [&dates, &sorted_dates]() {
+		sorted_dates = dates;
+		scpp::radix_sort(sorted_dates);
+		KeepValue(sorted_dates[0]);
+	});
+
+	// v is sorted now.
+	std::vector<int64> queries(NUM_LOOKUPS);
+	for(unsigned i=0; i<queries.size(); ++i)
+		queries[i] = data[RandomInt(0, data.size() - 1)];
+	runner.Run("sort/lower_bound_branchless", queries.size(), [&v, &queries]() {
+		unsigned64 sum = 0;
+		for(unsigned i=0; i<queries.size(); ++i)
+			sum += scpp::lower_bound(v, queries[i]);
+		KeepValue(sum);
+	});
+	runner.Run("sort/std_lower_bound", queries.size(), [&v, &queries]() {
+		unsigned64 sum = 0;
+		for(unsigned i=0; i<queries.size(); ++i)
+			sum += std::lower_bound(v.begin(), v.end(), queries[i]) - v.begin();
+		KeepValue(sum);
+	});
+
+	scpp::vector<int64> half1(data.begin(), data.begin() + SORT_SIZE / 2);
+	scpp::vector<int64> half2(data.begin() + SORT_SIZE / 2, data.end());
+	scpp::radix_sort(half1);
+	scpp::radix_sort(half2);
+	runner.Run("sort/merge", data.size(), [&half1, &half2, &v]() {
+		scpp::merge(half1, half2, v);
+		KeepValue(v[0]);
+	});
+
+	// Many duplicates: values in [0, SORT_SIZE / 16).
+	scpp::vector<int64> with_duplicates(SORT_SIZE);
+	for(unsigned64 i=0; i<with_duplicates.size(); ++i)
+		with_duplicates[i] = RandomInt(0, SORT_SIZE / 16 - 1);
+	scpp::radix_sort(with_duplicates);
+	runner.Run("sort/unique", with_duplicates.size(), [&with_duplicates, &v]() {
+		v = with_duplicates;
+		scpp::unique(v);
+		KeepValue(v[0]);
+	});
+}
+
+// ----------------------------------------------------------------------------
+// scpp_assert.hpp, scpp_assert_log.hpp
+
+void IgnoreFailure(const char*, unsigned, const char*) {
+}
+
+void BenchAssert(Runner& runner) {
+	// The cost of a failed check: formatting of the message and the handler.
+	volatile int bad_value = -1;
+	SCPP_AssertHandlerFunc previous = SCPP_SetAssertHandler(IgnoreFailure);
+	runner.Run("assert/failed_check_ignored", 1, [&bad_value]() {
+		int value = bad_value;
+		SCPP_ASSERT(value >= 0, "Value " << value << " must be non-negative");
+	});
+	SCPP_SetAssertHandler(previous);
+
+	if(!runner.Wanted("assert_log/"))
+		return;
+	if(!scpp::StartAsyncAssertLog("/dev/null")) {
+		fprintf(stderr, "Could not start the assert log, assert_log/ skipped\n");
+		return;
+	}
+	runner.Run("assert_log/failed_check_logged", 1, [&bad_value]() {
+		int value = bad_value;
+		SCPP_ASSERT(value >= 0, "Value " << value << " must be non-negative");
+	});
+	scpp::StopAsyncAssertLog();
+}
+
+// ----------------------------------------------------------------------------
+// JSON output and comparison of two runs
+
+bool IsChecked() {
+#ifdef SCPP_TEST_ASSERT_ON
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool IsSampled() {
+#ifdef SCPP_SAMPLED_CHECKS
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool IsInstrumented() {
+#ifdef SCPP_INSTRUMENT_CHECKS
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool IsOptimized() {
+#ifdef __OPTIMIZE__
+	return true;
+#else
+	return false;
+#endif
+}
+
+// Writes one result per line, which is what ReadResults() expects.
+void WriteJson(FILE* file, const std::vector<Result>& results) {
+	fprintf(file, "{\n");
+	fprintf(file, "\"build\": {\"checked\": %s, \"sampled\": %s, \"instrumented\": %s, "
+				  "\"optimized\": %s, \"compiler\": \"%s\"},\n",
+			IsChecked() ? "true" : "false", IsSampled() ? "true" : "false",
+			IsInstrumented() ? "true" : "false", IsOptimized() ? "true" : "false",
+			__VERSION__);
+	fprintf(file, "\"results\": [\n");
+	for(unsigned i=0; i<results.size(); ++i) {
+		const Result& r = results[i];
+		fprintf(file, "{\"name\": \"%s\", \"ns_per_item\": %.6g, \"items\": %llu, "
+					  "\"gflops\": %.6g, \"residual\": %.6g}%s\n",
+				r.name.c_str(), r.ns_per_item, (unsigned long long)r.items,
+				r.gflops, r.residual, i + 1 < results.size() ? "," : "");
+	}
+	fprintf(file, "]\n}\n");
+}
+
+// Reads the file written by WriteJson(): the build line into build,
+// and ns_per_item of every benchmark into results.
+bool ReadResults(const char* file_name, std::string& build,
+				 std::map<std::string, double>& results) {
+	std::ifstream file(file_name);
+	if(!file) {
+		fprintf(stderr, "Could not open %s\n", file_name);
+		return false;
+	}
+
+	static const char BUILD[] = "\"build\": ";
+	static const char NAME[] = "{\"name\": \"";
+	static const char NS_PER_ITEM[] = "\"ns_per_item\": ";
+	std::string line;
+	while(std::getline(file, line)) {
+		if(line.compare(0, sizeof BUILD - 1, BUILD) == 0) {
+			build = line.substr(sizeof BUILD - 1);
+			continue;
+		}
+		if(line.compare(0, sizeof NAME - 1, NAME) != 0)
+			continue;
+		size_t name_end = line.find('"', sizeof NAME - 1);
+		size_t value = line.find(NS_PER_ITEM);
+		if(name_end == std::string::npos || value == std::string::npos) {
+			fprintf(stderr, "Bad line in %s: %s\n", file_name, line.c_str());
+			return false;
+		}
+		std::string name = line.substr(sizeof NAME - 1, name_end - (sizeof NAME - 1));
+		results[name] = strtod(line.c_str() + value + sizeof NS_PER_ITEM - 1, NULL);
+	}
+
+	if(results.empty()) {
+		fprintf(stderr, "No results in %s\n", file_name);
+		return false;
+	}
+	return true;
+}
+
+// Prints the benchmarks of both runs side by side.
+// Returns 1 if any of them became slower by more than threshold percent, 0 otherwise.
+int Compare(const char* old_file, const char* new_file, double threshold) {
+	std::string old_build, new_build;
+	std::map<std::string, double> old_results, new_results;
+	if(!ReadResults(old_file, old_build, old_results) ||
+	   !ReadResults(new_file, new_build, new_results))
+		return 2;
+
+	printf("old: %s %s\n", old_file, old_build.c_str());
+	printf("new: %s %s\n\n", new_file, new_build.c_str());
+	printf("%-44s %12s %12s %9s\n", "benchmark", "old ns/item", "new ns/item", "change");
+
+	unsigned num_regressions = 0;
+	for(std::map<std::string, double>::const_iterator p=new_results.begin(); p!=new_results.end(); ++p) {
+		std::map<std::string, double>::const_iterator old = old_results.find(p->first);
+		if(old == old_results.end()) {
+			printf("%-44s %12s %12.3f %9s\n", p->first.c_str(), "-", p->second, "new");
+			continue;
+		}
+		double change = old->second > 0 ? (p->second / old->second - 1) * 100 : 0;
+		const char* verdict = "";
+		if(change > threshold) {
+			verdict = "  REGRESSION";
+			++num_regressions;
+		} else if(change < -threshold) {
+			verdict = "  faster";
+		}
+		printf("%-44s %12.3f %12.3f %+8.1f%%%s\n",
+			   p->first.c_str(), old->second, p->second, change, verdict);
+	}
+	for(std::map<std::string, double>::const_iterator p=old_results.begin(); p!=old_results.end(); ++p) {
+		if(new_results.find(p->first) == new_results.end())
+			printf("%-44s %12.3f %12s %9s\n", p->first.c_str(), p->second, "-", "removed");
+	}
+
+	printf("\n%u regression(s) above %.1f%%\n", num_regressions, threshold);
+	return num_regressions > 0 ? 1 : 0;
+}
+
+void PrintUsage(const char* program) {
+	fprintf(stderr,
+		"Usage: %s [--json FILE] [--filter PREFIX] [--min-time SECONDS]\n"
+		"       %s --compare OLD.json NEW.json [--threshold PERCENT]\n"
+		"  --json FILE         write the results as JSON to FILE, - for stdout\n"
+		"  --filter PREFIX     run only the benchmarks with names starting with PREFIX,\n"
+		"                      e.g. matrix/ or vector/scan\n"
+		"  --min-time SECONDS  time of one repetition of a benchmark (default 0.05)\n"
+		"  --compare OLD NEW   compare two JSON files, the exit code is 1 if any\n"
+		"                      benchmark is slower in NEW by more than the threshold\n"
+		"  --threshold PERCENT regression threshold for --compare (default 10)\n",
+		program, program);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+	Options options;
+	const char* compare_old = NULL;
+	const char* compare_new = NULL;
+	double threshold = 10;
+
+	for(int i=1; i<argc; ++i) {
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+		if(arg == "--json" && has_value) {
+			options.json_file = argv[++i];
+		} else if(arg == "--filter" && has_value) {
+			options.filter = argv[++i];
+		} else if(arg == "--min-time" && has_value) {
+			options.min_time = atof(argv[++i]);
+		} else if(arg == "--threshold" && has_value) {
+			threshold = atof(argv[++i]);
+		} else if(arg == "--compare" && i + 2 < argc) {
+			compare_old = argv[++i];
+			compare_new = argv[++i];
+		} else {
+			PrintUsage(argv[0]);
+			return 2;
+		}
+	}
+
+	if(compare_old != NULL)
+		return Compare(compare_old, compare_new, threshold);
+
+	if(options.min_time <= 0) {
+		PrintUsage(argv[0]);
+		return 2;
+	}
+
+	printf("scpp benchmarks, %s build\n", IsChecked() ? "checked" : "unchecked");
+	Runner runner(options);
+	BenchVector(runner);
+	BenchArrayAndSpan(runner);
+	BenchMatrix(runner);
+	BenchLinalg(runner);
+	BenchPointers(runner);
+	BenchDate(runner);
+	BenchArithmetic(runner);
+	BenchDecimal(runner);
+	BenchBoolVector(runner);
+	BenchAllocation(runner);
+	BenchTensor(runner);
+	BenchSort(runner);
+	BenchAssert(runner);
+
+	if(options.json_file.empty())
+		return 0;
+	FILE* file = options.json_file == "-" ? stdout : fopen(options.json_file.c_str(), "w");
+	if(file == NULL) {
+		fprintf(stderr, "Could not open %s for writing\n", options.json_file.c_str());
+		return 2;
+	}
+	WriteJson(file, runner.Results());
+	if(file != stdout)
+		fclose(file);
+	return 0;
+}
@@ -0,0 +1,148 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#include "scpp_bool_vector.hpp"
+
+namespace scpp {
+
+const BoolVector::size_type BoolVector::npos;
+
+BoolVector::BoolVector(size_type n, const std::vector<size_type>& indices)
+: words_(NumWords(n), 0), size_(n) {
+	set_indices(indices);
+}
+
+void BoolVector::resize(size_type n, bool value) {
+	size_type old_size = size_;
+	words_.resize(NumWords(n), value ? ~word_type(0) : 0);
+	size_ = n;
+	if(value && old_size < n && old_size % BITS_PER_WORD != 0)	// the rest of the old last word
+		words_[old_size / BITS_PER_WORD] |= ~word_type(0) << (old_size % BITS_PER_WORD);
+	ClearUnusedBits();
+}
+
+void BoolVector::push_back(bool x) {
+	if(size_ % BITS_PER_WORD == 0)
+		words_.push_back(0);
+	if(x)
+		words_.back() |= word_type(1) << (size_ % BITS_PER_WORD);
+	++size_;
+}
+
+void BoolVector::assign(bool value) {
+	word_type w = value ? ~word_type(0) : 0;
+	for(size_type i=0; i<words_.size(); ++i)
+		words_[i] = w;
+	ClearUnusedBits();
+}
+
+BoolVector& BoolVector::operator &= (const BoolVector& that) {
+	CheckSameSize(that);
+	word_type* w = words_.empty() ? NULL : &words_[0];
+	const word_type* v = that.words();
+	for(size_type i=0, n=words_.size(); i<n; ++i)
+		w[i] &= v[i];
+	return *this;
+}
+
+BoolVector& BoolVector::operator |= (const BoolVector& that) {
+	CheckSameSize(that);
+	word_type* w = words_.empty() ? NULL : &words_[0];
+	const word_type* v = that.words();
+	for(size_type i=0, n=words_.size(); i<n; ++i)
+		w[i] |= v[i];
+	return *this;
+}
+
+BoolVector& BoolVector::operator ^= (const BoolVector& that) {
+	CheckSameSize(that);
+	word_type* w = words_.empty() ? NULL : &words_[0];
+	const word_type* v = that.words();
+	for(size_type i=0, n=words_.size(); i<n; ++i)
+		w[i] ^= v[i];
+	return *this;
+}
+
+BoolVector& BoolVector::and_not(const BoolVector& that) {
+	CheckSameSize(that);
+	word_type* w = words_.empty() ? NULL : &words_[0];
+	const word_type* v = that.words();
+	for(size_type i=0, n=words_.size(); i<n; ++i)
+		w[i] &= ~v[i];
+	return *this;
+}
+
+BoolVector& BoolVector::flip() {
+	word_type* w = words_.empty() ? NULL : &words_[0];
+	for(size_type i=0, n=words_.size(); i<n; ++i)
+		w[i] = ~w[i];
+	ClearUnusedBits();
+	return *this;
+}
+
+BoolVector::size_type BoolVector::count() const {
+	const word_type* w = words();
+	size_type n = 0;
+	for(size_type i=0, num=words_.size(); i<num; ++i)
+		n += __builtin_popcountll(w[i]);
+	return n;
+}
+
+bool BoolVector::any() const {
+	const word_type* w = words();
+	word_type all = 0;
+	for(size_type i=0, num=words_.size(); i<num; ++i)
+		all |= w[i];
+	return all != 0;
+}
+
+BoolVector::size_type BoolVector::find_first() const {
+	for(size_type i=0; i<words_.size(); ++i)
+		if(words_[i] != 0)
+			return i * BITS_PER_WORD + __builtin_ctzll(words_[i]);
+	return npos;
+}
+
+BoolVector::size_type BoolVector::find_next(size_type index) const {
+	if(index >= size_)	// also npos, index + 1 would wrap around to 0
+		return npos;
+	size_type next = index + 1;
+	if(next == size_)
+		return npos;
+
+	size_type i = next / BITS_PER_WORD;
+	word_type w = words_[i] & (~word_type(0) << (next % BITS_PER_WORD));
+	while(w == 0) {
+		if(++i == words_.size())
+			return npos;
+		w = words_[i];
+	}
+	return i * BITS_PER_WORD + __builtin_ctzll(w);
+}
+
+void BoolVector::to_indices(std::vector<size_type>& indices) const {
+	for(size_type i=0; i<words_.size(); ++i) {
+		for(word_type w = words_[i]; w != 0; w &= w - 1)	// clears the lowest set bit
+			indices.push_back(i * BITS_PER_WORD + __builtin_ctzll(w));
+	}
+}
+
+void BoolVector::set_indices(const std::vector<size_type>& indices) {
+	for(size_t k=0; k<indices.size(); ++k) {
+		size_type index = indices[k];
+		SCPP_TEST_ASSERT(index < size_,
+			"Index " << index << " must be less than " << size_);
+		words_[index / BITS_PER_WORD] |= word_type(1) << (index % BITS_PER_WORD);
+	}
+}
+
+} // namespace scpp
@@ -0,0 +1,206 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#ifndef __SCPP_BOOL_VECTOR_HPP_INCLUDED__
+#define __SCPP_BOOL_VECTOR_HPP_INCLUDED__
+
+#include <ostream>
+#include <vector>
+
+#include "scpp_assert.hpp"
+#include "scpp_check_policy.hpp"
+#include "scpp_types.hpp"
+
+/*
+	Vector of bits, one bit per flag instead of a byte per scpp::Bool.
+	Features:
+		operator [] is checked (see DefaultCheck in scpp_check_policy.hpp)
+			and returns a proxy object for writing.
+		&=, |=, ^= and flip() work on whole 64-bit words, the loops are
+			simple enough for the compiler to vectorize them.
+		count() uses the popcount instruction (compile with -mpopcnt
+			or -march=native to get it instead of a library call).
+		find_first() / find_next() skip 64 clear bits at a time.
+		Conversion to and from a list of indices of the set bits.
+
+	Typical use:
+
+		scpp::BoolVector mask(n);
+		for(unsigned64 i=mask.find_first(); i!=scpp::BoolVector::npos; i=mask.find_next(i))
+			...
+*/
+namespace scpp {
+
+class BoolVector {
+ public:
+	typedef unsigned64 size_type;
+	typedef unsigned64 word_type;
+
+	enum { BITS_PER_WORD = 64 };
+
+	// Returned by find_first() and find_next() if there are no more set bits.
+	static const size_type npos = ~0ULL;
+
+	// Writable reference to one bit.
+	class reference {
+	 public:
+		operator bool () const { return (*word_ & mask_) != 0; }
+
+		reference& operator = (bool x) {
+			if(x)
+				*word_ |= mask_;
+			else
+				*word_ &= ~mask_;
+			return *this;
+		}
+
+		reference& operator = (const reference& that) {
+			return *this = bool(that);
+		}
+
+		void flip() { *word_ ^= mask_; }
+
+	 private:
+		friend class BoolVector;
+
+		reference(word_type* word, word_type mask)
+		: word_(word), mask_(mask)
+		{}
+
+		word_type*	word_;
+		word_type	mask_;
+	};
+
+	explicit BoolVector(size_type n = 0, bool value = false)
+	: words_(NumWords(n), value ? ~word_type(0) : 0), size_(n) {
+		ClearUnusedBits();
+	}
+
+	// Vector of size n with the bits listed in indices set.
+	BoolVector(size_type n, const std::vector<size_type>& indices);
+
+	// Note: we do not provide a copy-ctor and assignment operator.
+	// we rely on default versions of these methods generated by the compiler.
+
+	size_type size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+
+	void resize(size_type n, bool value = false);
+	void clear() { words_.clear(); size_ = 0; }
+	void push_back(bool x);
+
+	reference operator [] (size_type index) {
+		SCPP_CHECK(DefaultCheck, index < size_,
+			"Index " << index << " must be less than " << size_);
+		return reference(&words_[index / BITS_PER_WORD],
+						 word_type(1) << (index % BITS_PER_WORD));
+	}
+
+	bool operator [] (size_type index) const {
+		SCPP_CHECK(DefaultCheck, index < size_,
+			"Index " << index << " must be less than " << size_);
+		return (words_[index / BITS_PER_WORD] >> (index % BITS_PER_WORD)) & 1;
+	}
+
+	// Sets all bits to value.
+	void assign(bool value);
+
+	// Bitwise operations with a vector of the same size.
+	BoolVector& operator &= (const BoolVector& that);
+	BoolVector& operator |= (const BoolVector& that);
+	BoolVector& operator ^= (const BoolVector& that);
+
+	// *this &= ~that, e.g. removes the rows of the mask that from *this.
+	BoolVector& and_not(const BoolVector& that);
+
+	// Inverts all bits.
+	BoolVector& flip();
+
+	// Number of set bits.
+	size_type count() const;
+
+	bool any() const;
+	bool none() const { return !any(); }
+
+	// Index of the first set bit, npos if none.
+	size_type find_first() const;
+
+	// Index of the first set bit after index, npos if none
+	// or if index is npos.
+	size_type find_next(size_type index) const;
+
+	// Appends the indices of all set bits to indices, in increasing order.
+	void to_indices(std::vector<size_type>& indices) const;
+
+	// Sets the bits listed in indices, all of them must be less than size().
+	void set_indices(const std::vector<size_type>& indices);
+
+	// The packed bits, bit i is bit (i % 64) of word i / 64.
+	// Bits past size() in the last word are always 0.
+	const word_type* words() const { return words_.empty() ? NULL : &words_[0]; }
+	size_type num_words() const { return words_.size(); }
+
+ private:
+	std::vector<word_type>	words_;
+	size_type				size_;
+
+	static size_type NumWords(size_type n) {
+		return (n + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	}
+
+	void ClearUnusedBits() {
+		if(size_ % BITS_PER_WORD != 0)
+			words_.back() &= (word_type(1) << (size_ % BITS_PER_WORD)) - 1;
+	}
+
+	void CheckSameSize(const BoolVector& that) const {
+		SCPP_TEST_ASSERT(size_ == that.size_,
+			"BoolVector sizes " << size_ << " and " << that.size_ << " differ");
+		(void)that;	// unused without SCPP_TEST_ASSERT_ON
+	}
+};
+
+} // namespace scpp
+
+inline scpp::BoolVector operator & (const scpp::BoolVector& lhs, const scpp::BoolVector& rhs) {
+	scpp::BoolVector copy(lhs);
+	copy &= rhs;
+	return copy;
+}
+
+inline scpp::BoolVector operator | (const scpp::BoolVector& lhs, const scpp::BoolVector& rhs) {
+	scpp::BoolVector copy(lhs);
+	copy |= rhs;
+	return copy;
+}
+
+inline scpp::BoolVector operator ^ (const scpp::BoolVector& lhs, const scpp::BoolVector& rhs) {
+	scpp::BoolVector copy(lhs);
+	copy ^= rhs;
+	return copy;
+}
+
+inline scpp::BoolVector operator ~ (const scpp::BoolVector& v) {
+	scpp::BoolVector copy(v);
+	copy.flip();
+	return copy;
+}
+
+// Prints the bits as a string of 0s and 1s, the bit 0 first.
+inline
+std::ostream& operator << (std::ostream& os, const scpp::BoolVector& v) {
+	for(scpp::BoolVector::size_type i=0; i<v.size(); ++i)
+		os << (v[i] ? '1' : '0');
+	return os;
+}
+
+#endif // __SCPP_BOOL_VECTOR_HPP_INCLUDED__
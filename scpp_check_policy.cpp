@@ -0,0 +1,70 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#include "scpp_check_policy.hpp"
+
+#include <atomic>
+#include <stdlib.h>	// getenv, atoi
+
+namespace scpp {
+namespace {
+unsigned InitialSamplingPeriod() {
+	const char* env = getenv("SCPP_CHECK_SAMPLING_PERIOD");
+	int period = env != NULL ? atoi(env) : 0;
+	return period > 0 ? (unsigned)period : 100;
+}
+
+// 0 means not yet read from the environment. The constant initializer makes
+// it valid before any dynamic initialization, so RuntimeSampled checks
+// running in static constructors of other translation units sample correctly.
+std::atomic<unsigned> sampling_period(0);
+
+// xorshift32, one generator per thread.
+unsigned NextRandom() {
+	static SCPP_THREAD_LOCAL unsigned state = 0;
+	if(state == 0) {
+		// Seed from the address of the thread-local variable,
+		// so that the threads do not sample in step.
+		state = (unsigned)(reinterpret_cast<size_t>(&state) >> 4) | 1;
+	}
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+} // namespace
+
+void SetCheckSamplingPeriod(unsigned period) {
+	SCPP_ASSERT(period > 0, "Check sampling period must be positive");
+	sampling_period.store(period, std::memory_order_relaxed);
+}
+
+unsigned GetCheckSamplingPeriod() {
+	unsigned period = sampling_period.load(std::memory_order_relaxed);
+	if(period == 0) {
+		// If another thread or SetCheckSamplingPeriod() got there first,
+		// the compare-exchange fails and loads its value into period.
+		unsigned initial = InitialSamplingPeriod();
+		if(sampling_period.compare_exchange_strong(period, initial, std::memory_order_relaxed))
+			period = initial;
+	}
+	return period;
+}
+
+unsigned NextCheckSamplingInterval() {
+	unsigned period = GetCheckSamplingPeriod();
+	if(period <= 1)
+		return 0;
+	// Uniform in [0, 2*period-2], the mean is period-1.
+	return NextRandom() % (2 * period - 1);
+}
+} // namespace scpp
@@ -0,0 +1,127 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#ifndef __SCPP_CHECK_POLICY_HPP_INCLUDED__
+#define __SCPP_CHECK_POLICY_HPP_INCLUDED__
+
+#include "scpp_assert.hpp"
+
+/*
+	Checking policies.
+	The containers (scpp::vector, scpp::array, scpp::matrix) and the smart
+	pointers take a policy as the last template parameter, which decides
+	whether their sanity checks are performed:
+
+		NoCheck		-- never. Access compiles to exactly the same code
+					   as access to a raw array or pointer.
+		DebugCheck	-- only if SCPP_TEST_ASSERT_ON, i.e. the same as
+					   SCPP_TEST_ASSERT. This is the default.
+		AlwaysCheck	-- always, the same as SCPP_ASSERT.
+		Sampled<N>	-- one in N evaluations, counted per thread.
+		RuntimeSampled
+					-- on average one in N evaluations, where N is set
+					   at run time by SetCheckSamplingPeriod().
+
+	So one could keep the checks on the paths handling untrusted input
+	while the numeric kernels are compiled without them:
+
+		scpp::vector<double, std::allocator<double>, scpp::NoCheck> kernel_data;
+		scpp::vector<Order, std::allocator<Order>, scpp::AlwaysCheck> orders;
+
+	A policy is a class with a static function Enabled(), which returns
+	true if the next check is to be performed.
+
+	If SCPP_SAMPLED_CHECKS is defined, the default policy is RuntimeSampled
+	instead of DebugCheck, whether SCPP_TEST_ASSERT_ON or not. This gives
+	a statistical detection of out-of-range indices and NULL pointers
+	at a fraction of the cost of the full checks, e.g. in production.
+*/
+namespace scpp {
+
+struct NoCheck {
+	static bool Enabled() { return false; }
+};
+
+struct DebugCheck {
+	static bool Enabled() {
+#ifdef SCPP_TEST_ASSERT_ON
+		return true;
+#else
+		return false;
+#endif
+	}
+};
+
+struct AlwaysCheck {
+	static bool Enabled() { return true; }
+};
+
+template <unsigned N>
+struct Sampled {
+	typedef char period_must_be_positive[N > 0 ? 1 : -1];
+
+	static bool Enabled() {
+		static SCPP_THREAD_LOCAL unsigned countdown = 0;
+		if(countdown == 0) {
+			countdown = N - 1;
+			return true;
+		}
+		--countdown;
+		return false;
+	}
+};
+
+// Sets the average number of evaluations per one check done by
+// RuntimeSampled, for all threads. Period 1 means check every time.
+// The initial period is taken from the environment variable
+// SCPP_CHECK_SAMPLING_PERIOD, or is 100 if it is not set.
+void SetCheckSamplingPeriod(unsigned period);
+unsigned GetCheckSamplingPeriod();
+
+// Returns the number of evaluations to skip before the next check,
+// random with the mean GetCheckSamplingPeriod()-1, so that the checks
+// do not fall into step with the loops.
+unsigned NextCheckSamplingInterval();
+
+struct RuntimeSampled {
+	static bool Enabled() {
+		static SCPP_THREAD_LOCAL unsigned countdown = 0;
+		if(countdown != 0) {
+			--countdown;
+			return false;
+		}
+		countdown = NextCheckSamplingInterval();
+		return true;
+	}
+};
+
+// Checks if either of the policies does, e.g. for a function taking
+// two containers with different policies.
+template <typename Policy1, typename Policy2>
+struct AnyCheck {
+	static bool Enabled() { return Policy1::Enabled() || Policy2::Enabled(); }
+};
+
+#ifdef SCPP_SAMPLED_CHECKS
+typedef RuntimeSampled DefaultCheck;
+#else
+typedef DebugCheck DefaultCheck;
+#endif
+
+} // namespace scpp
+
+// Sanity check macro controlled by the checking policy Policy.
+#define SCPP_CHECK(Policy, condition, msg)          \
+    if(Policy::Enabled() && SCPP_COUNT_CHECK()      \
+        && SCPP_UNLIKELY(!(condition))) SCPP_ASSERT_FAILED(msg)
+
+#endif // __SCPP_CHECK_POLICY_HPP_INCLUDED__
@@ -0,0 +1,147 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#ifndef __SCPP_CHECKED_MATH_HPP_INCLUDED__
+#define __SCPP_CHECKED_MATH_HPP_INCLUDED__
+
+#include <stddef.h>	// size_t
+#include <type_traits>
+
+/*
+	Overflow-detecting integer arithmetic over contiguous arrays.
+	Checking every element with a branch (as CheckedArithmetic in
+	scpp_types.hpp does) prevents the compiler from vectorizing the loop,
+	so here the overflow bits of a block of elements are OR-ed together
+	without branches, and tested once per block.
+
+	Each function returns true if no element overflowed. On overflow it
+	returns false after the block containing it; the results of the
+	elements computed so far are wrapped around, the rest are not written.
+
+	Typical use:
+
+		scpp::vector<int> a, b, c;
+		...
+		SCPP_ASSERT(scpp::AddArrays(&a[0], &b[0], &c[0], a.size()),
+			"Overflow in a + b");
+
+	For integer types only. Requires C++11.
+*/
+namespace scpp {
+
+enum { OVERFLOW_CHECK_BLOCK = 256 };	// elements per overflow test
+
+namespace detail {
+
+template <typename T>
+struct CheckedMathTypes {
+	static_assert(std::is_integral<T>::value, "integer types only");
+	typedef typename std::make_unsigned<T>::type U;
+	static const U SIGN_BIT = U(1) << (sizeof(U) * 8 - 1);
+};
+
+// The wrapped sum a + b; adds the overflow bit to flag.
+template <typename T>
+struct AddWrapped {
+	typedef typename CheckedMathTypes<T>::U U;
+
+	T operator () (T a, T b, U& flag) const {
+		U ua = U(a), ub = U(b), ur = ua + ub;
+		if(std::is_signed<T>::value)
+			flag |= (ua ^ ur) & (ub ^ ur);	// both operands differ in sign from the result
+		else
+			flag |= U(ur < ua) << (sizeof(U) * 8 - 1);
+		return T(ur);
+	}
+};
+
+// The wrapped difference a - b; adds the overflow bit to flag.
+template <typename T>
+struct SubWrapped {
+	typedef typename CheckedMathTypes<T>::U U;
+
+	T operator () (T a, T b, U& flag) const {
+		U ua = U(a), ub = U(b), ur = ua - ub;
+		if(std::is_signed<T>::value)
+			flag |= (ua ^ ub) & (ua ^ ur);
+		else
+			flag |= U(ua < ub) << (sizeof(U) * 8 - 1);
+		return T(ur);
+	}
+};
+
+// The wrapped product a * b; adds the overflow bit to flag.
+template <typename T>
+struct MulWrapped {
+	typedef typename CheckedMathTypes<T>::U U;
+
+	T operator () (T a, T b, U& flag) const {
+		T r;
+		flag |= U(__builtin_mul_overflow(a, b, &r)) << (sizeof(U) * 8 - 1);
+		return r;
+	}
+};
+
+template <typename T, typename Op>
+bool ApplyBlockwise(const T* a, const T* b, T* result, size_t n, Op op) {
+	typedef typename CheckedMathTypes<T>::U U;
+	for(size_t begin=0; begin<n; begin+=OVERFLOW_CHECK_BLOCK) {
+		size_t end = n - begin < OVERFLOW_CHECK_BLOCK ? n : begin + OVERFLOW_CHECK_BLOCK;
+		U flag = 0;
+		for(size_t i=begin; i<end; ++i)
+			result[i] = op(a[i], b[i], flag);
+		if(flag & CheckedMathTypes<T>::SIGN_BIT)
+			return false;
+	}
+	return true;
+}
+} // namespace detail
+
+// result[i] = a[i] + b[i] for i in [0, n).
+template <typename T>
+bool AddArrays(const T* a, const T* b, T* result, size_t n) {
+	return detail::ApplyBlockwise(a, b, result, n, detail::AddWrapped<T>());
+}
+
+// result[i] = a[i] - b[i] for i in [0, n).
+template <typename T>
+bool SubArrays(const T* a, const T* b, T* result, size_t n) {
+	return detail::ApplyBlockwise(a, b, result, n, detail::SubWrapped<T>());
+}
+
+// result[i] = a[i] * b[i] for i in [0, n).
+template <typename T>
+bool MulArrays(const T* a, const T* b, T* result, size_t n) {
+	return detail::ApplyBlockwise(a, b, result, n, detail::MulWrapped<T>());
+}
+
+// sum = a[0] + ... + a[n-1]. On overflow sum is not changed.
+template <typename T>
+bool SumArray(const T* a, size_t n, T& sum) {
+	typedef typename detail::CheckedMathTypes<T>::U U;
+	detail::AddWrapped<T> add;
+	T total = 0;
+	for(size_t begin=0; begin<n; begin+=OVERFLOW_CHECK_BLOCK) {
+		size_t end = n - begin < OVERFLOW_CHECK_BLOCK ? n : begin + OVERFLOW_CHECK_BLOCK;
+		U flag = 0;
+		for(size_t i=begin; i<end; ++i)
+			total = add(total, a[i], flag);
+		if(flag & detail::CheckedMathTypes<T>::SIGN_BIT)
+			return false;
+	}
+	sum = total;
+	return true;
+}
+
+} // namespace scpp
+
+#endif // __SCPP_CHECKED_MATH_HPP_INCLUDED__
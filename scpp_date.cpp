@@ -14,6 +14,7 @@
 
 #include <string.h>  // strlen
 #include <stdlib.h>  // atoi
+#include <stdio.h>   // sprintf
 
 namespace scpp {
 Date::Date()
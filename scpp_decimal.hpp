@@ -0,0 +1,391 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#ifndef __SCPP_DECIMAL_HPP_INCLUDED__
+#define __SCPP_DECIMAL_HPP_INCLUDED__
+
+#include <math.h>	// floor, ceil, trunc, round, nearbyint
+#include <ostream>
+
+#include "scpp_assert.hpp"
+#include "scpp_types.hpp"
+
+/*
+	Fixed-point decimal number with Scale digits after the decimal point,
+	e.g. a price 12.3450 as Decimal<4> is stored as the integer 123450.
+	Features:
+		Addition, subtraction and comparisons are exact integer operations.
+		Multiplication and division round the result with an explicit
+			rounding mode (ROUND_HALF_EVEN by the operators * and /).
+		Overflow of the 64-bit integer calls the error handler
+			#ifdef SCPP_TEST_ASSERT_ON, otherwise the result wraps around.
+		FromChars() and ToChars() parse and format without allocating
+			memory and without any floating point arithmetic.
+
+	Scale must be 0 .. 18. No implicit type conversions are allowed.
+	Uses the GCC and Clang overflow intrinsics and 128-bit integers.
+*/
+namespace scpp {
+
+enum RoundingMode {
+	ROUND_DOWN,			// toward zero
+	ROUND_FLOOR,		// toward -infinity
+	ROUND_CEILING,		// toward +infinity
+	ROUND_HALF_UP,		// to nearest, ties away from zero
+	ROUND_HALF_EVEN		// to nearest, ties to even
+};
+
+namespace detail {
+
+template <unsigned N>
+struct Pow10 {
+	static const int64 value = 10 * Pow10<N-1>::value;
+};
+
+template <>
+struct Pow10<0> {
+	static const int64 value = 1;
+};
+
+inline int64 DecimalAdd(int64 a, int64 b) {
+	int64 r;
+	if(__builtin_add_overflow(a, b, &r)) {
+		SCPP_TEST_ASSERT(false, "Decimal overflow in " << a << " + " << b);
+	}
+	return r;
+}
+
+inline int64 DecimalSub(int64 a, int64 b) {
+	int64 r;
+	if(__builtin_sub_overflow(a, b, &r)) {
+		SCPP_TEST_ASSERT(false, "Decimal overflow in " << a << " - " << b);
+	}
+	return r;
+}
+
+inline int64 DecimalMul(int64 a, int64 b) {
+	int64 r;
+	if(__builtin_mul_overflow(a, b, &r)) {
+		SCPP_TEST_ASSERT(false, "Decimal overflow in " << a << " * " << b);
+	}
+	return r;
+}
+
+// Rounds the magnitude q of a quotient. half_cmp is negative, 0 or positive
+// if the discarded remainder is below, exactly or above one half,
+// inexact is true if it is not 0.
+inline unsigned __int128 RoundMagnitude(unsigned __int128 q, bool negative,
+										int half_cmp, bool inexact,
+										RoundingMode mode) {
+	switch(mode) {
+		case ROUND_DOWN:
+			return q;
+		case ROUND_FLOOR:
+			return q + (negative && inexact);
+		case ROUND_CEILING:
+			return q + (!negative && inexact);
+		case ROUND_HALF_UP:
+			return q + (inexact && half_cmp >= 0);
+		case ROUND_HALF_EVEN:
+			return q + (half_cmp > 0 || (half_cmp == 0 && (q & 1)));
+	}
+	return q;
+}
+
+// Converts the magnitude back to a signed number.
+inline int64 SignedUnits(unsigned __int128 magnitude, bool negative) {
+	const unsigned __int128 limit = (unsigned __int128)1 << 63;
+	if(magnitude > limit - (negative ? 0 : 1)) {
+		SCPP_TEST_ASSERT(false, "Decimal overflow: the result does not fit into 64 bits");
+	}
+	unsigned64 u = (unsigned64)magnitude;
+	return (int64)(negative ? 0 - u : u);
+}
+
+// Returns n / d rounded, d != 0.
+inline int64 DivideRounded(__int128 n, __int128 d, RoundingMode mode) {
+	bool negative = (n < 0) != (d < 0);
+	unsigned __int128 un = n < 0 ? 0 - (unsigned __int128)n : (unsigned __int128)n;
+	unsigned __int128 ud = d < 0 ? 0 - (unsigned __int128)d : (unsigned __int128)d;
+	unsigned __int128 q = un / ud;
+	unsigned __int128 r = un % ud;
+	int half_cmp = r * 2 < ud ? -1 : (r * 2 == ud ? 0 : 1);
+	return SignedUnits(RoundMagnitude(q, negative, half_cmp, r != 0, mode), negative);
+}
+
+// Converts units of scale From to units of scale To. The direction is
+// chosen at compile time, so only the multiplication or the division is compiled.
+template <unsigned From, unsigned To, bool Up = (To >= From)>
+struct Rescaler {
+	static int64 Units(int64 units, RoundingMode /*mode*/) {
+		return DecimalMul(units, Pow10<To - From>::value);
+	}
+};
+
+template <unsigned From, unsigned To>
+struct Rescaler<From, To, false> {
+	static int64 Units(int64 units, RoundingMode mode) {
+		return DivideRounded(units, Pow10<From - To>::value, mode);
+	}
+};
+} // namespace detail
+
+template <unsigned Scale>
+class Decimal {
+	typedef char scale_must_be_0_to_18[Scale <= 18 ? 1 : -1];
+
+public:
+	// 10 to the power of Scale, i.e. the number of units in 1.
+	static const int64 ONE = detail::Pow10<Scale>::value;
+
+	// Maximum number of characters written by ToChars():
+	// the sign, 19 digits and the decimal point.
+	enum { MAX_CHARS = 21 };
+
+	// Creates 0.
+	Decimal()
+	: units_(0)
+	{}
+
+	// Integer number of whole units, e.g. Decimal<2>(5) is 5.00.
+	explicit Decimal(int64 whole)
+	: units_(detail::DecimalMul(whole, ONE))
+	{}
+
+	// Decimal from the number of 1/ONE fractions, e.g. FromUnits(123450)
+	// is 12.3450 as Decimal<4>.
+	static Decimal FromUnits(int64 units) {
+		Decimal d;
+		d.units_ = units;
+		return d;
+	}
+
+	// The nearest (in the sense of mode) Decimal to a double.
+	static Decimal FromDouble(double x, RoundingMode mode=ROUND_HALF_EVEN) {
+		double scaled = x * (double)ONE;
+		switch(mode) {
+			case ROUND_DOWN:		scaled = trunc(scaled); break;
+			case ROUND_FLOOR:		scaled = floor(scaled); break;
+			case ROUND_CEILING:		scaled = ceil(scaled); break;
+			case ROUND_HALF_UP:		scaled = round(scaled); break;
+			case ROUND_HALF_EVEN:	scaled = nearbyint(scaled); break;
+		}
+		// Permanent check: the conversion of NaN or of an out-of-range double
+		// to int64 is undefined behavior. If the error handler returns,
+		// the result is saturated, and NaN gives 0.
+		bool in_range = scaled >= -9223372036854775808.0 && scaled < 9223372036854775808.0;
+		SCPP_ASSERT(in_range, "Decimal overflow: " << x << " is out of range");
+		if(!in_range)
+			return FromUnits(scaled > 0 ? 0x7FFFFFFFFFFFFFFFLL : (scaled < 0 ? -0x7FFFFFFFFFFFFFFFLL - 1 : 0));
+		return FromUnits((int64)scaled);
+	}
+
+	// Number of 1/ONE fractions.
+	int64 Units() const { return units_; }
+
+	double AsDouble() const { return (double)units_ / (double)ONE; }
+
+	// Returns negative int, 0 or positive int in cases of *this<d, *this==d and *this>d.
+	int CompareTo(const Decimal& d) const {
+		return units_ < d.units_ ? -1 : (units_ > d.units_ ? 1 : 0);
+	}
+
+	SCPP_DEFINE_COMPARISON_OPERATORS(Decimal)
+
+	Decimal operator - () const {
+		return FromUnits(detail::DecimalSub(0, units_));
+	}
+
+	Decimal& operator += (const Decimal& d) {
+		units_ = detail::DecimalAdd(units_, d.units_);
+		return *this;
+	}
+
+	Decimal& operator -= (const Decimal& d) {
+		units_ = detail::DecimalSub(units_, d.units_);
+		return *this;
+	}
+
+	// Multiplication by an integer is exact.
+	Decimal& operator *= (int64 x) {
+		units_ = detail::DecimalMul(units_, x);
+		return *this;
+	}
+
+	// *this * d rounded to Scale digits.
+	Decimal Mul(const Decimal& d, RoundingMode mode) const {
+		return FromUnits(detail::DivideRounded((__int128)units_ * d.units_, ONE, mode));
+	}
+
+	// *this / d rounded to Scale digits.
+	Decimal Div(const Decimal& d, RoundingMode mode) const {
+		SCPP_TEST_ASSERT(d.units_ != 0, "Attempt to divide by 0");
+		return FromUnits(detail::DivideRounded((__int128)units_ * ONE, d.units_, mode));
+	}
+
+	// *this / x rounded to Scale digits.
+	Decimal Div(int64 x, RoundingMode mode) const {
+		SCPP_TEST_ASSERT(x != 0, "Attempt to divide by 0");
+		return FromUnits(detail::DivideRounded(units_, x, mode));
+	}
+
+	// The same number with NewScale digits, rounded if NewScale < Scale.
+	template <unsigned NewScale>
+	Decimal<NewScale> Rescale(RoundingMode mode=ROUND_HALF_EVEN) const {
+		return Decimal<NewScale>::FromUnits(
+			detail::Rescaler<Scale, NewScale>::Units(units_, mode));
+	}
+
+private:
+	int64 units_;
+};
+
+/*
+	Parses a decimal number from [first, last): an optional '-', digits,
+	and optionally '.' followed by digits, e.g. "-12.345" or ".5".
+	Fraction digits beyond Scale are rounded according to mode.
+	Returns the pointer to the first character that is not a part of the
+	number, or first if there is no number or it does not fit into Decimal;
+	value is not changed in this case.
+*/
+template <unsigned Scale>
+const char* FromChars(const char* first, const char* last,
+					  Decimal<Scale>& value, RoundingMode mode=ROUND_HALF_EVEN) {
+	const char* p = first;
+	bool negative = false;
+	if(p != last && *p == '-') {
+		negative = true;
+		++p;
+	}
+
+	// Magnitude in units; a 128-bit integer cannot overflow before
+	// the 19 digits that fit into int64 are exceeded, checked below.
+	unsigned __int128 magnitude = 0;
+	unsigned digits = 0;
+	for(; p != last && *p >= '0' && *p <= '9'; ++p, ++digits) {
+		magnitude = magnitude * 10 + (unsigned)(*p - '0');
+		if(magnitude > ((unsigned __int128)1 << 63))
+			return first;
+	}
+
+	unsigned fraction_digits = 0;
+	int first_discarded = -1;	// the first digit beyond Scale
+	bool sticky = false;		// any non-zero digit after it
+	if(p != last && *p == '.' && p + 1 != last && p[1] >= '0' && p[1] <= '9') {
+		for(++p; p != last && *p >= '0' && *p <= '9'; ++p, ++digits) {
+			unsigned digit = (unsigned)(*p - '0');
+			if(fraction_digits < Scale) {
+				magnitude = magnitude * 10 + digit;
+				++fraction_digits;
+			} else if(first_discarded < 0) {
+				first_discarded = (int)digit;
+			} else if(digit != 0) {
+				sticky = true;
+			}
+		}
+	}
+	if(digits == 0)
+		return first;
+
+	for(; fraction_digits < Scale; ++fraction_digits)
+		magnitude *= 10;
+	if(magnitude > ((unsigned __int128)1 << 63))
+		return first;
+
+	int half_cmp = first_discarded < 5 ? -1 : (first_discarded > 5 || sticky ? 1 : 0);
+	bool inexact = first_discarded > 0 || sticky;
+	magnitude = detail::RoundMagnitude(magnitude, negative, half_cmp, inexact, mode);
+	if(magnitude > ((unsigned __int128)1 << 63) - (negative ? 0 : 1))
+		return first;
+
+	unsigned64 u = (unsigned64)magnitude;
+	value = Decimal<Scale>::FromUnits((int64)(negative ? 0 - u : u));
+	return p;
+}
+
+/*
+	Writes the number into [first, last) with exactly Scale digits after
+	the decimal point, e.g. "-12.3450" for Decimal<4>, no '\0' is added.
+	Returns the pointer past the last character written, or NULL
+	if the buffer is too small; Decimal<Scale>::MAX_CHARS is always enough.
+*/
+template <unsigned Scale>
+char* ToChars(char* first, char* last, const Decimal<Scale>& value) {
+	char buffer[Decimal<Scale>::MAX_CHARS];
+	char* p = buffer + Decimal<Scale>::MAX_CHARS;
+
+	int64 units = value.Units();
+	unsigned64 magnitude = units < 0 ? 0 - (unsigned64)units : (unsigned64)units;
+	for(unsigned i=0; i<Scale; ++i) {
+		*--p = (char)('0' + magnitude % 10);
+		magnitude /= 10;
+	}
+	if(Scale > 0)
+		*--p = '.';
+	do {
+		*--p = (char)('0' + magnitude % 10);
+		magnitude /= 10;
+	} while(magnitude != 0);
+	if(units < 0)
+		*--p = '-';
+
+	unsigned length = (unsigned)(buffer + Decimal<Scale>::MAX_CHARS - p);
+	if(last - first < (long)length)
+		return NULL;
+	for(unsigned i=0; i<length; ++i)
+		first[i] = p[i];
+	return first + length;
+}
+
+} // namespace scpp
+
+template <unsigned Scale>
+inline std::ostream& operator<<(std::ostream& os, const scpp::Decimal<Scale>& d) {
+	char buffer[scpp::Decimal<Scale>::MAX_CHARS];
+	char* end = scpp::ToChars(buffer, buffer + scpp::Decimal<Scale>::MAX_CHARS, d);
+	os.write(buffer, end - buffer);
+	return os;
+}
+
+template <unsigned Scale>
+inline scpp::Decimal<Scale> operator + (const scpp::Decimal<Scale>& lhs,
+										 const scpp::Decimal<Scale>& rhs) {
+	scpp::Decimal<Scale> copy(lhs);
+	return (copy += rhs);
+}
+
+template <unsigned Scale>
+inline scpp::Decimal<Scale> operator - (const scpp::Decimal<Scale>& lhs,
+										 const scpp::Decimal<Scale>& rhs) {
+	scpp::Decimal<Scale> copy(lhs);
+	return (copy -= rhs);
+}
+
+template <unsigned Scale>
+inline scpp::Decimal<Scale> operator * (const scpp::Decimal<Scale>& lhs,
+										 const scpp::Decimal<Scale>& rhs) {
+	return lhs.Mul(rhs, scpp::ROUND_HALF_EVEN);
+}
+
+template <unsigned Scale>
+inline scpp::Decimal<Scale> operator * (const scpp::Decimal<Scale>& lhs, int64 x) {
+	scpp::Decimal<Scale> copy(lhs);
+	return (copy *= x);
+}
+
+template <unsigned Scale>
+inline scpp::Decimal<Scale> operator / (const scpp::Decimal<Scale>& lhs,
+										 const scpp::Decimal<Scale>& rhs) {
+	return lhs.Div(rhs, scpp::ROUND_HALF_EVEN);
+}
+
+#endif // __SCPP_DECIMAL_HPP_INCLUDED__
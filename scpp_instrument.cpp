@@ -0,0 +1,196 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#include "scpp_instrument.hpp"
+
+#include <algorithm>	// sort, find
+#include <fstream>
+#include <iomanip>		// setw
+#include <iostream>		// cerr
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>		// pair
+
+#include <stdlib.h>		// getenv, atexit
+
+namespace scpp {
+
+thread_local CheckCounter* check_counter_chunks[MAX_CHECK_COUNTER_CHUNKS];
+
+namespace {
+
+const unsigned MAX_SITES = CHECK_COUNTER_CHUNK * MAX_CHECK_COUNTER_CHUNKS;
+
+struct SiteInfo {
+	const char*	file_name;
+	unsigned	line_number;
+};
+
+struct Registry {
+	std::mutex						mutex;
+	std::vector<SiteInfo>			sites;
+	std::vector<unsigned long long>	retired_counts;
+	std::vector<CheckCounter**>		live_threads;
+
+	// Created by the first call, which could come from a check evaluated
+	// during the static initialization of another translation unit.
+	// Never destroyed, so that it could be used at exit.
+	static Registry& Get() {
+		static Registry* registry = new Registry;
+		return *registry;
+	}
+};
+
+std::atomic<double> cycles_per_check(2.0);
+
+// Counters of threads that are being destroyed, the counts are lost.
+CheckCounter discarded_counters[CHECK_COUNTER_CHUNK];
+
+thread_local bool thread_exiting = false;
+
+// Folds the counters of an exiting thread into retired_counts.
+struct ThreadCountersOwner {
+	bool registered;
+
+	~ThreadCountersOwner() {
+		thread_exiting = true;
+		if(!registered)
+			return;
+
+		Registry& r = Registry::Get();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		r.live_threads.erase(std::find(r.live_threads.begin(), r.live_threads.end(),
+									   check_counter_chunks));
+		r.retired_counts.resize(r.sites.size(), 0);
+		for(unsigned chunk=0; chunk<MAX_CHECK_COUNTER_CHUNKS; ++chunk) {
+			CheckCounter* counters = check_counter_chunks[chunk];
+			if(counters == NULL)
+				continue;
+			for(unsigned i=0; i<CHECK_COUNTER_CHUNK; ++i) {
+				unsigned id = chunk * CHECK_COUNTER_CHUNK + i;
+				if(id < r.retired_counts.size())
+					r.retired_counts[id] += counters[i].load(std::memory_order_relaxed);
+			}
+			delete [] counters;
+			check_counter_chunks[chunk] = NULL;
+		}
+	}
+};
+
+thread_local ThreadCountersOwner owner = { false };
+
+void WriteReportAtExit() {
+	const char* file_name = getenv("SCPP_CHECK_REPORT");
+	if(file_name != NULL && *file_name != '\0') {
+		std::ofstream file(file_name);
+		if(file) {
+			WriteCheckReport(file);
+			return;
+		}
+	}
+	WriteCheckReport(std::cerr);
+}
+
+bool MoreCounts(const CheckSiteCount& lhs, const CheckSiteCount& rhs) {
+	return lhs.count > rhs.count;
+}
+} // namespace
+
+unsigned RegisterCheckSite(const char* file_name, unsigned line_number) {
+	Registry& r = Registry::Get();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	if(r.sites.empty())
+		atexit(WriteReportAtExit);
+	if(r.sites.size() == MAX_SITES)
+		return MAX_SITES - 1;	// the last site collects the rest
+	SiteInfo site = { file_name, line_number };
+	r.sites.push_back(site);
+	return (unsigned)r.sites.size() - 1;
+}
+
+CheckCounter* AllocateCheckCounters(unsigned chunk) {
+	if(thread_exiting)
+		return discarded_counters;
+
+	CheckCounter* counters = new CheckCounter[CHECK_COUNTER_CHUNK];
+	for(unsigned i=0; i<CHECK_COUNTER_CHUNK; ++i)
+		counters[i].store(0, std::memory_order_relaxed);
+
+	Registry& r = Registry::Get();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	if(!owner.registered) {
+		owner.registered = true;
+		r.live_threads.push_back(check_counter_chunks);
+	}
+	check_counter_chunks[chunk] = counters;
+	return counters;
+}
+
+void GetCheckSiteCounts(std::vector<CheckSiteCount>& counts) {
+	Registry& r = Registry::Get();
+	std::lock_guard<std::mutex> lock(r.mutex);
+
+	std::vector<unsigned long long> totals(r.retired_counts);
+	totals.resize(r.sites.size(), 0);
+	for(size_t t=0; t<r.live_threads.size(); ++t) {
+		for(unsigned chunk=0; chunk<MAX_CHECK_COUNTER_CHUNKS; ++chunk) {
+			CheckCounter* counters = r.live_threads[t][chunk];
+			if(counters == NULL)
+				continue;
+			for(unsigned i=0; i<CHECK_COUNTER_CHUNK; ++i) {
+				unsigned id = chunk * CHECK_COUNTER_CHUNK + i;
+				if(id < totals.size())
+					totals[id] += counters[i].load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// The same file and line could be registered several times:
+	// from several translation units and template instantiations.
+	std::map<std::pair<std::string, unsigned>, size_t> index;
+	counts.clear();
+	for(size_t id=0; id<r.sites.size(); ++id) {
+		std::pair<std::string, unsigned> key(r.sites[id].file_name, r.sites[id].line_number);
+		std::map<std::pair<std::string, unsigned>, size_t>::iterator it = index.find(key);
+		if(it != index.end()) {
+			counts[it->second].count += totals[id];
+		} else {
+			index[key] = counts.size();
+			CheckSiteCount c = { r.sites[id].file_name, r.sites[id].line_number, totals[id] };
+			counts.push_back(c);
+		}
+	}
+
+	std::stable_sort(counts.begin(), counts.end(), MoreCounts);
+}
+
+void WriteCheckReport(std::ostream& os) {
+	std::vector<CheckSiteCount> counts;
+	GetCheckSiteCounts(counts);
+
+	double cycles = cycles_per_check.load(std::memory_order_relaxed);
+	os << "# SCPP check evaluations, estimated " << cycles << " cycles per check\n"
+	   << "#" << std::setw(20) << "count" << std::setw(22) << "est. cycles" << "  site\n";
+	for(size_t i=0; i<counts.size(); ++i) {
+		os << " " << std::setw(20) << counts[i].count
+		   << std::setw(22) << (unsigned long long)(counts[i].count * cycles)
+		   << "  " << counts[i].file_name << " #" << counts[i].line_number << "\n";
+	}
+	os.flush();
+}
+
+void SetCheckCostEstimate(double cycles) {
+	cycles_per_check.store(cycles, std::memory_order_relaxed);
+}
+
+} // namespace scpp
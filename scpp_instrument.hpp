@@ -0,0 +1,94 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#ifndef __SCPP_INSTRUMENT_HPP_INCLUDED__
+#define __SCPP_INSTRUMENT_HPP_INCLUDED__
+
+/*
+	Instrumentation of the sanity checks.
+	If SCPP_INSTRUMENT_CHECKS is defined, every SCPP_ASSERT, SCPP_TEST_ASSERT
+	(if SCPP_TEST_ASSERT_ON) and SCPP_CHECK site registers itself on its first
+	evaluation and counts its evaluations in a per-thread counter,
+	so that the counting threads never contend with each other.
+
+	At exit the report, sorted by the number of evaluations, is written
+	to the file named by the environment variable SCPP_CHECK_REPORT,
+	or to stderr if it is not set. WriteCheckReport() writes it on demand.
+	Each line of the report contains the count and the estimated cost
+	in CPU cycles (count * SetCheckCostEstimate()) of one check site.
+
+	A check in a header, e.g. in scpp::vector::operator[], is one site
+	for all its callers and all template instantiations.
+	Requires C++11 (thread_local and atomics).
+*/
+
+#include <atomic>
+#include <ostream>
+#include <stddef.h>	// NULL
+#include <vector>
+
+namespace scpp {
+
+struct CheckSiteCount {
+	const char*			file_name;
+	unsigned			line_number;
+	unsigned long long	count;
+};
+
+// Evaluation counts of all check sites, sorted by count in descending order.
+void GetCheckSiteCounts(std::vector<CheckSiteCount>& counts);
+
+// Writes the report: count, estimated cycles, file and line of each site.
+void WriteCheckReport(std::ostream& os);
+
+// Sets the estimated cost of one evaluation of a check in CPU cycles,
+// used for the report only. The default is 2 (a compare and a branch).
+void SetCheckCostEstimate(double cycles_per_check);
+
+// Returns a new site id, called once per site by SCPP_COUNT_CHECK().
+unsigned RegisterCheckSite(const char* file_name, unsigned line_number);
+
+enum {
+	CHECK_COUNTER_CHUNK = 1024,		// counters allocated together
+	MAX_CHECK_COUNTER_CHUNKS = 256	// at most 256K sites
+};
+
+typedef std::atomic<unsigned long long> CheckCounter;
+
+// Counters of the current thread, allocated chunk by chunk.
+extern thread_local CheckCounter* check_counter_chunks[MAX_CHECK_COUNTER_CHUNKS];
+
+// Allocates the chunk of counters of the current thread.
+CheckCounter* AllocateCheckCounters(unsigned chunk);
+
+inline void CountCheck(unsigned site_id) {
+	unsigned chunk = site_id / CHECK_COUNTER_CHUNK;
+	CheckCounter* counters = check_counter_chunks[chunk];
+	if(counters == NULL)
+		counters = AllocateCheckCounters(chunk);
+	// Only this thread writes the counter, so no atomic increment is needed:
+	// the atomic type only makes it safe to read from the reporting thread.
+	CheckCounter& c = counters[site_id % CHECK_COUNTER_CHUNK];
+	c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+} // namespace scpp
+
+// Counts one evaluation of the check site, always true.
+#define SCPP_COUNT_CHECK()                                                  \
+    ([]() {                                                                 \
+        static const unsigned scpp_site_id =                               \
+            scpp::RegisterCheckSite(__FILE__, __LINE__);                    \
+        scpp::CountCheck(scpp_site_id);                                     \
+    }(), true)
+
+#endif // __SCPP_INSTRUMENT_HPP_INCLUDED__
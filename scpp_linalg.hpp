@@ -0,0 +1,390 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#ifndef __SCPP_LINALG_HPP_INCLUDED__
+#define __SCPP_LINALG_HPP_INCLUDED__
+
+#include <algorithm>	// min, swap
+#include <math.h>		// fabs, sqrt
+#include <thread>
+#include <vector>
+
+#include "scpp_assert.hpp"
+#include "scpp_matrix.hpp"
+#include "scpp_types.hpp"
+
+/*
+	Dense linear algebra for scpp::matrix<float> and scpp::matrix<double>.
+	Features:
+		lu_factorize()			-- P * A = L * U with partial pivoting.
+		cholesky_factorize()	-- A = L * L^T of a symmetric positive
+								   definite matrix.
+		solve_lower(), solve_upper(), solve_lower_transposed(), lu_solve(),
+		cholesky_solve()
+								-- A * X = B for all columns of B at once.
+	The factorizations work on panels of LINALG_BLOCK columns: the panel is
+	factorized column by column, and the rest of the matrix (the trailing
+	matrix) is updated by one matrix product, which does most of the work
+	and reuses every loaded element LINALG_BLOCK times. This update is split
+	by rows between num_threads threads (0 means one per hardware thread).
+
+	Typical use:
+
+		scpp::matrix<double> a(n, n), b(n, 1);
+		...
+		std::vector<unsigned64> pivots;
+		if(scpp::lu_factorize(a, pivots))
+			scpp::lu_solve(a, pivots, b);	// b is now the solution
+
+	The sizes of the matrices and zeros on the diagonal of a triangular
+	matrix are checked with the check policies of the matrices.
+	The matrices must be RowMajor, use convert_layout() for ColMajor ones.
+	Requires C++11 (threads).
+*/
+namespace scpp {
+
+enum {
+	LINALG_BLOCK = 64,			// columns per panel
+	LINALG_COLUMN_TILE = 256,	// columns of the product computed together
+	LINALG_MIN_THREAD_ROWS = 64	// fewer rows per thread are not worth it
+};
+
+namespace detail {
+
+// C[i][j] -= sum over p of A[i][p] * B[p][j], for i in [row_lo, row_hi),
+// j in [0, n), or only j <= i + diagonal if lower is true.
+// Row-major with leading dimensions lda, ldb, ldc, except that A[i][p]
+// is a[i * lda + p * a_step]: a_step != 1 reads A transposed in place.
+template <typename T>
+void UpdateRows(T* c, unsigned64 ldc, const T* a, unsigned64 lda,
+				const T* b, unsigned64 ldb, unsigned64 row_lo, unsigned64 row_hi,
+				unsigned64 n, unsigned64 k, bool lower, unsigned64 diagonal,
+				unsigned64 a_step) {
+	for(unsigned64 j0=0; j0<n; j0+=LINALG_COLUMN_TILE) {
+		unsigned64 j1 = std::min<unsigned64>(j0 + LINALG_COLUMN_TILE, n);
+		for(unsigned64 i=row_lo; i<row_hi; ++i) {
+			unsigned64 end = lower ? std::min<unsigned64>(j1, i + diagonal + 1) : j1;
+			if(end <= j0)
+				continue;
+			T* ci = c + i * ldc;
+			const T* ai = a + i * lda;
+			for(unsigned64 p=0; p<k; ++p) {
+				const T aip = ai[p * a_step];
+				const T* bp = b + p * ldb;
+				for(unsigned64 j=j0; j<end; ++j)
+					ci[j] -= aip * bp[j];
+			}
+		}
+	}
+}
+
+// C -= A * B for the m x n matrix C, see UpdateRows(),
+// the rows are split between num_threads threads.
+template <typename T>
+void UpdateTrailing(T* c, unsigned64 ldc, const T* a, unsigned64 lda,
+					const T* b, unsigned64 ldb, unsigned64 m, unsigned64 n,
+					unsigned64 k, unsigned num_threads,
+					bool lower = false, unsigned64 diagonal = 0,
+					unsigned64 a_step = 1) {
+	if(num_threads == 0)
+		num_threads = std::max(1u, std::thread::hardware_concurrency());
+	num_threads = (unsigned)std::min<unsigned64>(num_threads, m / LINALG_MIN_THREAD_ROWS);
+	if(num_threads <= 1) {
+		UpdateRows(c, ldc, a, lda, b, ldb, 0, m, n, k, lower, diagonal, a_step);
+		return;
+	}
+
+	std::vector<std::thread> threads;
+	unsigned64 rows_per_thread = (m + num_threads - 1) / num_threads;
+	for(unsigned t=1; t<num_threads; ++t) {
+		unsigned64 lo = t * rows_per_thread;
+		unsigned64 hi = std::min<unsigned64>(lo + rows_per_thread, m);
+		if(lo < hi)
+			threads.push_back(std::thread(UpdateRows<T>, c, ldc, a, lda, b, ldb,
+										  lo, hi, n, k, lower, diagonal, a_step));
+	}
+	UpdateRows(c, ldc, a, lda, b, ldb, 0, std::min(rows_per_thread, m), n, k,
+			   lower, diagonal, a_step);
+	for(unsigned t=0; t<threads.size(); ++t)
+		threads[t].join();
+}
+} // namespace detail
+
+/*
+	LU factorization with partial pivoting of the square matrix a, in place:
+	on return the strict lower triangle of a holds L (its unit diagonal
+	is not stored) and the upper triangle holds U. At step i the rows i
+	and pivots[i] were swapped. Returns false if a is singular (a zero
+	pivot was found), the content of a is undefined in this case.
+*/
+template <typename T, typename A, typename C>
+bool lu_factorize(matrix<T, A, C, RowMajor>& a, std::vector<unsigned64>& pivots,
+				  unsigned num_threads = 1) {
+	SCPP_CHECK(C, a.num_rows() == a.num_cols(),
+		"Matrix " << a.num_rows() << " x " << a.num_cols() << " must be square");
+	const unsigned64 n = a.num_rows();
+	T* d = a.data();
+	pivots.resize(n);
+
+	for(unsigned64 k0=0; k0<n; k0+=LINALG_BLOCK) {
+		const unsigned64 k1 = std::min<unsigned64>(k0 + LINALG_BLOCK, n);
+
+		// Panel: columns [k0, k1), all rows below k0.
+		for(unsigned64 j=k0; j<k1; ++j) {
+			unsigned64 p = j;
+			for(unsigned64 i=j+1; i<n; ++i)
+				if(fabs(d[i * n + j]) > fabs(d[p * n + j]))
+					p = i;
+			pivots[j] = p;
+			if(d[p * n + j] == T(0))
+				return false;
+			if(p != j)
+				std::swap_ranges(d + j * n, d + j * n + n, d + p * n);
+
+			const T inverse = T(1) / d[j * n + j];
+			for(unsigned64 i=j+1; i<n; ++i) {
+				T* row = d + i * n;
+				const T l = row[j] *= inverse;
+				const T* pivot_row = d + j * n;
+				for(unsigned64 c=j+1; c<k1; ++c)
+					row[c] -= l * pivot_row[c];
+			}
+		}
+		if(k1 == n)
+			break;
+
+		// U12 = L11^-1 * A12, rows [k0, k1), columns [k1, n).
+		for(unsigned64 i=k0+1; i<k1; ++i) {
+			T* row = d + i * n;
+			for(unsigned64 p=k0; p<i; ++p) {
+				const T l = row[p];
+				const T* u = d + p * n;
+				for(unsigned64 c=k1; c<n; ++c)
+					row[c] -= l * u[c];
+			}
+		}
+
+		// A22 -= L21 * U12
+		detail::UpdateTrailing(d + k1 * n + k1, n, d + k1 * n + k0, n,
+							   d + k0 * n + k1, n, n - k1, n - k1, k1 - k0, num_threads);
+	}
+	return true;
+}
+
+/*
+	Cholesky factorization A = L * L^T of the symmetric positive definite
+	matrix a, in place: on return the lower triangle of a holds L and the
+	strict upper triangle is 0. Only the lower triangle of a is read.
+	Returns false if a is not positive definite.
+*/
+template <typename T, typename A, typename C>
+bool cholesky_factorize(matrix<T, A, C, RowMajor>& a, unsigned num_threads = 1) {
+	SCPP_CHECK(C, a.num_rows() == a.num_cols(),
+		"Matrix " << a.num_rows() << " x " << a.num_cols() << " must be square");
+	const unsigned64 n = a.num_rows();
+	T* d = a.data();
+	std::vector<T> panel_transposed;
+
+	for(unsigned64 k0=0; k0<n; k0+=LINALG_BLOCK) {
+		const unsigned64 k1 = std::min<unsigned64>(k0 + LINALG_BLOCK, n);
+
+		// Diagonal block L11.
+		for(unsigned64 j=k0; j<k1; ++j) {
+			T* row_j = d + j * n;
+			T s = row_j[j];
+			for(unsigned64 p=k0; p<j; ++p)
+				s -= row_j[p] * row_j[p];
+			if(!(s > T(0)))
+				return false;
+			const T l_jj = row_j[j] = sqrt(s);
+			for(unsigned64 i=j+1; i<k1; ++i) {
+				T* row_i = d + i * n;
+				T t = row_i[j];
+				for(unsigned64 p=k0; p<j; ++p)
+					t -= row_i[p] * row_j[p];
+				row_i[j] = t / l_jj;
+			}
+		}
+		if(k1 == n)
+			break;
+
+		// L21 = A21 * L11^-T, row by row.
+		for(unsigned64 i=k1; i<n; ++i) {
+			T* row_i = d + i * n;
+			for(unsigned64 j=k0; j<k1; ++j) {
+				const T* row_j = d + j * n;
+				T t = row_i[j];
+				for(unsigned64 p=k0; p<j; ++p)
+					t -= row_i[p] * row_j[p];
+				row_i[j] = t / row_j[j];
+			}
+		}
+
+		// A22 -= L21 * L21^T, lower triangle only.
+		const unsigned64 m = n - k1, kb = k1 - k0;
+		panel_transposed.resize(kb * m);
+		detail::TransposeBlock(d + k1 * n + k0, n, &panel_transposed[0], m, m, kb);
+		detail::UpdateTrailing(d + k1 * n + k1, n, d + k1 * n + k0, n,
+							   &panel_transposed[0], m, m, m, kb, num_threads, true, 0);
+	}
+
+	for(unsigned64 i=0; i<n; ++i)
+		for(unsigned64 j=i+1; j<n; ++j)
+			d[i * n + j] = T(0);
+	return true;
+}
+
+/*
+	Solves L * X = B for the lower triangular l, in place: b is replaced by X.
+	If unit_diagonal is true, the diagonal of l is taken as 1 and not read,
+	as in the result of lu_factorize().
+*/
+template <typename T, typename A, typename C, typename A2, typename C2>
+void solve_lower(const matrix<T, A, C, RowMajor>& l, matrix<T, A2, C2, RowMajor>& b,
+				 bool unit_diagonal = false, unsigned num_threads = 1) {
+	SCPP_CHECK(C, l.num_rows() == l.num_cols(),
+		"Matrix " << l.num_rows() << " x " << l.num_cols() << " must be square");
+	typedef AnyCheck<C, C2> Check;
+	SCPP_CHECK(Check, b.num_rows() == l.num_rows(),
+		"Right-hand side has " << b.num_rows() << " rows instead of " << l.num_rows());
+	const unsigned64 n = l.num_rows(), k = b.num_cols();
+	const T* dl = l.data();
+	T* db = b.data();
+
+	for(unsigned64 i0=0; i0<n; i0+=LINALG_BLOCK) {
+		const unsigned64 i1 = std::min<unsigned64>(i0 + LINALG_BLOCK, n);
+		// B1 -= L10 * X0 for the rows already solved.
+		if(i0 > 0)
+			detail::UpdateTrailing(db + i0 * k, k, dl + i0 * n, n, db, k,
+								   i1 - i0, k, i0, num_threads);
+		for(unsigned64 i=i0; i<i1; ++i) {
+			T* bi = db + i * k;
+			for(unsigned64 p=i0; p<i; ++p) {
+				const T lip = dl[i * n + p];
+				const T* bp = db + p * k;
+				for(unsigned64 j=0; j<k; ++j)
+					bi[j] -= lip * bp[j];
+			}
+			if(!unit_diagonal) {
+				SCPP_CHECK(C, dl[i * n + i] != T(0), "Zero on the diagonal in row " << i);
+				const T inverse = T(1) / dl[i * n + i];
+				for(unsigned64 j=0; j<k; ++j)
+					bi[j] *= inverse;
+			}
+		}
+	}
+}
+
+// Solves U * X = B for the upper triangular u, in place: b is replaced by X.
+template <typename T, typename A, typename C, typename A2, typename C2>
+void solve_upper(const matrix<T, A, C, RowMajor>& u, matrix<T, A2, C2, RowMajor>& b,
+				 unsigned num_threads = 1) {
+	SCPP_CHECK(C, u.num_rows() == u.num_cols(),
+		"Matrix " << u.num_rows() << " x " << u.num_cols() << " must be square");
+	typedef AnyCheck<C, C2> Check;
+	SCPP_CHECK(Check, b.num_rows() == u.num_rows(),
+		"Right-hand side has " << b.num_rows() << " rows instead of " << u.num_rows());
+	const unsigned64 n = u.num_rows(), k = b.num_cols();
+	const T* du = u.data();
+	T* db = b.data();
+
+	for(unsigned64 i1=n; i1>0; ) {
+		const unsigned64 i0 = i1 > LINALG_BLOCK ? i1 - LINALG_BLOCK : 0;
+		// B1 -= U12 * X2 for the rows already solved.
+		if(i1 < n)
+			detail::UpdateTrailing(db + i0 * k, k, du + i0 * n + i1, n, db + i1 * k, k,
+								   i1 - i0, k, n - i1, num_threads);
+		for(unsigned64 i=i1; i-- > i0; ) {
+			T* bi = db + i * k;
+			for(unsigned64 p=i+1; p<i1; ++p) {
+				const T uip = du[i * n + p];
+				const T* bp = db + p * k;
+				for(unsigned64 j=0; j<k; ++j)
+					bi[j] -= uip * bp[j];
+			}
+			SCPP_CHECK(C, du[i * n + i] != T(0), "Zero on the diagonal in row " << i);
+			const T inverse = T(1) / du[i * n + i];
+			for(unsigned64 j=0; j<k; ++j)
+				bi[j] *= inverse;
+		}
+		i1 = i0;
+	}
+}
+
+/*
+	Solves L^T * X = B for the lower triangular l, in place: b is replaced
+	by X. L^T is read from l directly, no transposed copy is made.
+*/
+template <typename T, typename A, typename C, typename A2, typename C2>
+void solve_lower_transposed(const matrix<T, A, C, RowMajor>& l, matrix<T, A2, C2, RowMajor>& b,
+							unsigned num_threads = 1) {
+	SCPP_CHECK(C, l.num_rows() == l.num_cols(),
+		"Matrix " << l.num_rows() << " x " << l.num_cols() << " must be square");
+	typedef AnyCheck<C, C2> Check;
+	SCPP_CHECK(Check, b.num_rows() == l.num_rows(),
+		"Right-hand side has " << b.num_rows() << " rows instead of " << l.num_rows());
+	const unsigned64 n = l.num_rows(), k = b.num_cols();
+	const T* dl = l.data();
+	T* db = b.data();
+
+	for(unsigned64 i1=n; i1>0; ) {
+		const unsigned64 i0 = i1 > LINALG_BLOCK ? i1 - LINALG_BLOCK : 0;
+		// B1 -= L21^T * X2 for the rows already solved, L21^T[i][p] = L21[p][i].
+		if(i1 < n)
+			detail::UpdateTrailing(db + i0 * k, k, dl + i1 * n + i0, 1, db + i1 * k, k,
+								   i1 - i0, k, n - i1, num_threads, false, 0, n);
+		for(unsigned64 i=i1; i-- > i0; ) {
+			T* bi = db + i * k;
+			for(unsigned64 p=i+1; p<i1; ++p) {
+				const T lpi = dl[p * n + i];
+				const T* bp = db + p * k;
+				for(unsigned64 j=0; j<k; ++j)
+					bi[j] -= lpi * bp[j];
+			}
+			SCPP_CHECK(C, dl[i * n + i] != T(0), "Zero on the diagonal in row " << i);
+			const T inverse = T(1) / dl[i * n + i];
+			for(unsigned64 j=0; j<k; ++j)
+				bi[j] *= inverse;
+		}
+		i1 = i0;
+	}
+}
+
+// Solves A * X = B in place, lu and pivots are the result of lu_factorize(A).
+template <typename T, typename A, typename C, typename A2, typename C2>
+void lu_solve(const matrix<T, A, C, RowMajor>& lu, const std::vector<unsigned64>& pivots,
+			  matrix<T, A2, C2, RowMajor>& b, unsigned num_threads = 1) {
+	typedef AnyCheck<C, C2> Check;
+	SCPP_CHECK(Check, b.num_rows() == lu.num_rows(),
+		"Right-hand side has " << b.num_rows() << " rows instead of " << lu.num_rows());
+	SCPP_CHECK(C, pivots.size() == lu.num_rows(),
+		"Number of pivots " << pivots.size() << " differs from the matrix size " << lu.num_rows());
+	const unsigned64 k = b.num_cols();
+	T* db = b.data();
+	for(unsigned64 i=0; i<pivots.size(); ++i)
+		if(pivots[i] != i)
+			std::swap_ranges(db + i * k, db + i * k + k, db + pivots[i] * k);
+	solve_lower(lu, b, true, num_threads);
+	solve_upper(lu, b, num_threads);
+}
+
+// Solves A * X = B in place, l is the result of cholesky_factorize(A).
+template <typename T, typename A, typename C, typename A2, typename C2>
+void cholesky_solve(const matrix<T, A, C, RowMajor>& l, matrix<T, A2, C2, RowMajor>& b,
+					unsigned num_threads = 1) {
+	solve_lower(l, b, false, num_threads);
+	solve_lower_transposed(l, b, num_threads);
+}
+
+} // namespace scpp
+
+#endif // __SCPP_LINALG_HPP_INCLUDED__
@@ -13,33 +13,78 @@
 #ifndef __SCPP_MATRIX_HPP_INCLUDED__
 #define __SCPP_MATRIX_HPP_INCLUDED__
 
+#include <algorithm>	// swap
 #include <ostream>
 #include <vector>
 
 #include "scpp_assert.hpp"
+#include "scpp_check_policy.hpp"
+#include "scpp_types.hpp"
 
 namespace scpp {
 
+// Layouts of the matrix elements in memory:
+// RowMajor -- rows are contiguous (the default),
+// ColMajor -- columns are contiguous, as in Fortran and LAPACK.
+struct RowMajor {
+	enum { ROW_MAJOR = 1 };
+
+	static unsigned64 Index(unsigned64 row, unsigned64 col,
+							unsigned64 /*num_rows*/, unsigned64 num_cols) {
+		return num_cols * row + col;
+	}
+};
+
+struct ColMajor {
+	enum { ROW_MAJOR = 0 };
+
+	static unsigned64 Index(unsigned64 row, unsigned64 col,
+							unsigned64 num_rows, unsigned64 /*num_cols*/) {
+		return num_rows * col + row;
+	}
+};
+
 // Two-dimensional rectangular matrix.
-template <typename T>
+// The allocator A could be e.g. scpp::ArenaAllocator<T> (see scpp_arena.hpp).
+// The checks are controlled by the policy Check (see scpp_check_policy.hpp).
+// Layout is RowMajor or ColMajor, see above.
+// Sizes and indices are 64-bit, the number of elements num_rows * num_cols
+// is checked for overflow. Requires C++11.
+template <typename T, typename A = std::allocator<T>, typename Check = DefaultCheck,
+		  typename Layout = RowMajor>
 class matrix {
   public:
-	typedef unsigned size_type;
+	typedef unsigned64 size_type;
 
 	matrix(size_type num_rows, size_type num_cols)
-		: rows_(num_rows), cols_(num_cols), data_(num_rows * num_cols)
+		: rows_(num_rows), cols_(num_cols), data_(NumElements(num_rows, num_cols))
 	{
-		SCPP_TEST_ASSERT(num_rows > 0, 
+		SCPP_CHECK(Check, num_rows > 0, 
 			"Number of rows in a matrix must be positive");
-		SCPP_TEST_ASSERT(num_cols > 0, 
+		SCPP_CHECK(Check, num_cols > 0, 
 			"Number of columns in a matrix must be positive");
 	}
 
 	matrix(size_type num_rows, size_type num_cols, const T& init_value)
-		: rows_(num_rows), cols_(num_cols), data_(num_rows * num_cols, init_value)
+		: rows_(num_rows), cols_(num_cols), data_(NumElements(num_rows, num_cols), init_value)
+	{
+		SCPP_CHECK(Check, num_rows > 0, "Number of rows in a matrix must be positive");
+		SCPP_CHECK(Check, num_cols > 0, "Number of columns in a matrix must be positive");
+	}
+
+	// Same as above, with memory taken from the allocator alloc.
+	matrix(size_type num_rows, size_type num_cols, const A& alloc)
+		: rows_(num_rows), cols_(num_cols), data_(NumElements(num_rows, num_cols), T(), alloc)
+	{
+		SCPP_CHECK(Check, num_rows > 0, "Number of rows in a matrix must be positive");
+		SCPP_CHECK(Check, num_cols > 0, "Number of columns in a matrix must be positive");
+	}
+
+	matrix(size_type num_rows, size_type num_cols, const T& init_value, const A& alloc)
+		: rows_(num_rows), cols_(num_cols), data_(NumElements(num_rows, num_cols), init_value, alloc)
 	{
-		SCPP_TEST_ASSERT(num_rows > 0, "Number of rows in a matrix must be positive");
-		SCPP_TEST_ASSERT(num_cols > 0, "Number of columns in a matrix must be positive");
+		SCPP_CHECK(Check, num_rows > 0, "Number of rows in a matrix must be positive");
+		SCPP_CHECK(Check, num_cols > 0, "Number of columns in a matrix must be positive");
 	}
 
 	size_type num_rows() const { return rows_; }
@@ -56,24 +101,196 @@ class matrix {
 		return data_[ index( row, col ) ];
 	}
 
+	// Returns pointer to the first of num_cols() contiguous elements of the row,
+	// see also scpp::row_span() in scpp_span.hpp. RowMajor only.
+	T* row_data( size_type row )
+	{
+		static_assert(Layout::ROW_MAJOR, "row_data() is for RowMajor matrices only");
+		return &data_[ index( row, 0 ) ];
+	}
+
+	const T* row_data( size_type row ) const
+	{
+		static_assert(Layout::ROW_MAJOR, "row_data() is for RowMajor matrices only");
+		return &data_[ index( row, 0 ) ];
+	}
+
+	// Returns pointer to the first of num_rows() contiguous elements of the column,
+	// see also scpp::col_span() in scpp_span.hpp. ColMajor only.
+	T* col_data( size_type col )
+	{
+		static_assert(!Layout::ROW_MAJOR, "col_data() is for ColMajor matrices only");
+		return &data_[ index( 0, col ) ];
+	}
+
+	const T* col_data( size_type col ) const
+	{
+		static_assert(!Layout::ROW_MAJOR, "col_data() is for ColMajor matrices only");
+		return &data_[ index( 0, col ) ];
+	}
+
+	// Returns pointer to all num_rows() * num_cols() elements in the order of Layout.
+	T* data() { return &data_[0]; }
+	const T* data() const { return &data_[0]; }
+
+	// Transposes the matrix in place: num_rows() and num_cols() are swapped.
+	// A square matrix is transposed block by block, others by following
+	// the permutation cycles without extra memory, which is slower than
+	// transpose(src, dst).
+	void transpose();
+
   private:
 	size_type rows_, cols_;
-	std::vector<T> data_;
+	std::vector<T, A> data_;
+
+	static size_type NumElements(size_type num_rows, size_type num_cols) {
+		size_type n;
+		SCPP_ASSERT(!__builtin_mul_overflow(num_rows, num_cols, &n),
+			"Matrix size " << num_rows << " x " << num_cols << " is too large");
+		return n;
+	}
 
 	size_type index(size_type row, size_type col) const {
-		SCPP_TEST_ASSERT(row < rows_, "Row " << row  << " must be less than " << rows_);
- 		SCPP_TEST_ASSERT(col < cols_, "Column " << col  << " must be less than " << cols_);
-		return cols_ * row + col;
+		SCPP_CHECK(Check, row < rows_, "Row " << row  << " must be less than " << rows_);
+ 		SCPP_CHECK(Check, col < cols_, "Column " << col  << " must be less than " << cols_);
+		return Layout::Index(row, col, rows_, cols_);
 	}
 };
 
-}  // namespace scpp
+namespace detail {
+
+enum { TRANSPOSE_BLOCK = 32 };	// tile of 32 x 32 elements stays in L1 cache
+
+// Cache-oblivious transpose of the outer x inner array src with leading
+// dimension src_ld into the inner x outer array dst with dst_ld:
+// dst[i * dst_ld + o] = src[o * src_ld + i]. Splits the longer side
+// in half until the tile fits into the cache.
+template <typename T>
+void TransposeBlock(const T* src, unsigned64 src_ld, T* dst, unsigned64 dst_ld,
+					unsigned64 outer, unsigned64 inner) {
+	if(outer <= TRANSPOSE_BLOCK && inner <= TRANSPOSE_BLOCK) {
+		for(unsigned64 o=0; o<outer; ++o)
+			for(unsigned64 i=0; i<inner; ++i)
+				dst[i * dst_ld + o] = src[o * src_ld + i];
+	} else if(outer >= inner) {
+		unsigned64 half = outer / 2;
+		TransposeBlock(src, src_ld, dst, dst_ld, half, inner);
+		TransposeBlock(src + half * src_ld, src_ld, dst + half, dst_ld, outer - half, inner);
+	} else {
+		unsigned64 half = inner / 2;
+		TransposeBlock(src, src_ld, dst, dst_ld, outer, half);
+		TransposeBlock(src + half, src_ld, dst + half * dst_ld, dst_ld, outer, inner - half);
+	}
+}
 
+// In-place transpose of the n x n array, tile by tile:
+// the tiles above the diagonal are swapped with the ones below.
 template <typename T>
+void TransposeSquare(T* data, unsigned64 n) {
+	for(unsigned64 r0=0; r0<n; r0+=TRANSPOSE_BLOCK) {
+		unsigned64 r1 = std::min<unsigned64>(r0 + TRANSPOSE_BLOCK, n);
+		for(unsigned64 c0=r0; c0<n; c0+=TRANSPOSE_BLOCK) {
+			unsigned64 c1 = std::min<unsigned64>(c0 + TRANSPOSE_BLOCK, n);
+			for(unsigned64 r=r0; r<r1; ++r)
+				for(unsigned64 c=(c0 == r0 ? r + 1 : c0); c<c1; ++c)
+					std::swap(data[r * n + c], data[c * n + r]);
+		}
+	}
+}
+
+// In-place transpose of the outer x inner array: the element at position p
+// moves to p * outer mod (size - 1). Each permutation cycle is followed
+// once, from its smallest position, so no memory is allocated: a position
+// starts a cycle only if no smaller one is met on the way back to it.
+template <typename T>
+void TransposeCycles(T* data, unsigned64 outer, unsigned64 inner) {
+	const unsigned64 last = outer * inner - 1;
+	for(unsigned64 start=1; start<last; ++start) {
+		unsigned64 p = start * outer % last;
+		while(p > start)
+			p = p * outer % last;
+		if(p < start)
+			continue;	// the cycle has been moved from p already
+		T value = data[start];
+		p = start;
+		do {
+			unsigned64 next = p * outer % last;	// where data[p] goes
+			std::swap(value, data[next]);
+			p = next;
+		} while(p != start);
+	}
+}
+} // namespace detail
+
+template <typename T, typename A, typename Check, typename Layout>
+void matrix<T, A, Check, Layout>::transpose() {
+	// In storage order the matrix is an outer x inner array.
+	size_type outer = Layout::ROW_MAJOR ? rows_ : cols_;
+	size_type inner = Layout::ROW_MAJOR ? cols_ : rows_;
+	if(outer == inner)
+		detail::TransposeSquare(&data_[0], outer);
+	else if(outer > 1 && inner > 1) {
+		// The cycles compute p * outer for all p < outer * inner,
+		// the largest of these products must fit into 64 bits.
+		NumElements(outer * inner, outer);
+		detail::TransposeCycles(&data_[0], outer, inner);
+	}
+	std::swap(rows_, cols_);
+}
+
+// Writes the transpose of src into dst, which must be num_cols x num_rows
+// of src, using cache-oblivious recursive tiling. The sizes are checked
+// if the policy of either matrix checks, the same in convert_layout().
+template <typename T, typename A, typename C, typename A2, typename C2, typename Layout>
+void transpose(const matrix<T, A, C, Layout>& src, matrix<T, A2, C2, Layout>& dst) {
+	typedef AnyCheck<C, C2> Check;
+	SCPP_CHECK(Check, dst.num_rows() == src.num_cols() && dst.num_cols() == src.num_rows(),
+		"Transpose of " << src.num_rows() << " x " << src.num_cols()
+		<< " matrix does not fit into " << dst.num_rows() << " x " << dst.num_cols());
+	unsigned64 outer = Layout::ROW_MAJOR ? src.num_rows() : src.num_cols();
+	unsigned64 inner = Layout::ROW_MAJOR ? src.num_cols() : src.num_rows();
+	detail::TransposeBlock(src.data(), inner, dst.data(), outer, outer, inner);
+}
+
+// Copies src into dst of the same size and another layout,
+// e.g. a RowMajor matrix into a ColMajor one for a column-wise algorithm.
+template <typename T, typename A, typename C, typename A2, typename C2, typename Layout>
+void convert_layout(const matrix<T, A, C, Layout>& src, matrix<T, A2, C2, Layout>& dst) {
+	typedef AnyCheck<C, C2> Check;
+	SCPP_CHECK(Check, dst.num_rows() == src.num_rows() && dst.num_cols() == src.num_cols(),
+		"Matrix " << src.num_rows() << " x " << src.num_cols()
+		<< " does not fit into " << dst.num_rows() << " x " << dst.num_cols());
+	std::copy(src.data(), src.data() + src.num_rows() * src.num_cols(), dst.data());
+}
+
+template <typename T, typename A, typename C, typename A2, typename C2>
+void convert_layout(const matrix<T, A, C, RowMajor>& src, matrix<T, A2, C2, ColMajor>& dst) {
+	typedef AnyCheck<C, C2> Check;
+	SCPP_CHECK(Check, dst.num_rows() == src.num_rows() && dst.num_cols() == src.num_cols(),
+		"Matrix " << src.num_rows() << " x " << src.num_cols()
+		<< " does not fit into " << dst.num_rows() << " x " << dst.num_cols());
+	// The storage of dst is the transposed storage of src.
+	detail::TransposeBlock(src.data(), src.num_cols(), dst.data(), src.num_rows(),
+						   src.num_rows(), src.num_cols());
+}
+
+template <typename T, typename A, typename C, typename A2, typename C2>
+void convert_layout(const matrix<T, A, C, ColMajor>& src, matrix<T, A2, C2, RowMajor>& dst) {
+	typedef AnyCheck<C, C2> Check;
+	SCPP_CHECK(Check, dst.num_rows() == src.num_rows() && dst.num_cols() == src.num_cols(),
+		"Matrix " << src.num_rows() << " x " << src.num_cols()
+		<< " does not fit into " << dst.num_rows() << " x " << dst.num_cols());
+	detail::TransposeBlock(src.data(), src.num_rows(), dst.data(), src.num_cols(),
+						   src.num_cols(), src.num_rows());
+}
+
+}  // namespace scpp
+
+template <typename T, typename A, typename Check, typename Layout>
 inline
-std::ostream& operator << (std::ostream& os, const scpp::matrix<T>& m) {
-	for( unsigned r =0; r<m.num_rows(); ++r ) {
-		for( unsigned c=0; c<m.num_cols(); ++c ) {
+std::ostream& operator << (std::ostream& os, const scpp::matrix<T, A, Check, Layout>& m) {
+	for( unsigned64 r =0; r<m.num_rows(); ++r ) {
+		for( unsigned64 c=0; c<m.num_cols(); ++c ) {
 			os << m(r,c);
 			if( c + 1 < m.num_cols() )
 				os << "\t";
@@ -14,11 +14,13 @@
 #define __SCPP_PTR_HPP_INCLUDED__
 
 #include "scpp_assert.hpp"
+#include "scpp_check_policy.hpp"
 
 namespace scpp {
 
 // Template pointer, does not take ownership of an object.
-template <typename T>
+// The checks are controlled by the policy Check (see scpp_check_policy.hpp).
+template <typename T, typename Check = DefaultCheck>
 class Ptr {
   public:
 
@@ -30,18 +32,18 @@ class Ptr {
 		return ptr_;
 	}
 
-	Ptr<T>& operator=(T* p) {
+	Ptr<T, Check>& operator=(T* p) {
 		ptr_ = p;
 		return *this;
 	}
 
 	T* operator->() const {						
-		SCPP_TEST_ASSERT(ptr_ != NULL, "Attempt to use operator -> on NULL pointer.");
+		SCPP_CHECK(Check, ptr_ != NULL, "Attempt to use operator -> on NULL pointer.");
 		return ptr_;
 	}
 
 	T& operator* () const { 
-		SCPP_TEST_ASSERT(ptr_ != NULL, "Attempt to use operator * on NULL pointer.");
+		SCPP_CHECK(Check, ptr_ != NULL, "Attempt to use operator * on NULL pointer.");
 		return *ptr_;
 	}
 
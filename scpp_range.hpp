@@ -0,0 +1,220 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#ifndef __SCPP_RANGE_HPP_INCLUDED__
+#define __SCPP_RANGE_HPP_INCLUDED__
+
+#include "scpp_assert.hpp"
+#include "scpp_check_policy.hpp"
+#include "scpp_types.hpp"
+#include "scpp_array.hpp"
+#include "scpp_vector.hpp"
+#include "scpp_matrix.hpp"
+#include "scpp_span.hpp"
+
+/*
+	Hoisted range checks.
+	The operators [] of scpp containers check the index on every access,
+	and with SCPP_TEST_ASSERT_ON the branch inside a hot loop prevents
+	vectorization. The functions below check the whole range [lo, hi)
+	against the size of a container once, with the checking policy of
+	the container, and then access the elements without checks, so the
+	loop compiles as if it was written over a raw pointer:
+
+		scpp::for_each_index(v, lo, hi, Scale(2.0));	// f(i, v[i])
+
+		scpp::checked_range<double> r = scpp::make_checked_range(v, lo, hi);
+		for(unsigned64 i=r.lo(); i<r.hi(); ++i)
+			sum += r[i];								// no check here
+
+	The operator [] of checked_range is not checked even with
+	SCPP_TEST_ASSERT_ON, so that checked builds run the loop at the speed
+	of release ones. Define SCPP_CHECKED_RANGE_PARANOID to check there
+	that the index is within [lo, hi) as well.
+*/
+namespace scpp {
+
+template <typename Check>
+inline void CheckRange(unsigned64 lo, unsigned64 hi, unsigned64 size) {
+	SCPP_CHECK(Check, lo <= hi && hi <= size,
+		"Range [" << lo << ", " << hi << ") must be within size " << size);
+}
+
+// Range of indices [lo, hi) of a contiguous container,
+// validated once on construction by the policy Check,
+// accessed without checks.
+template <typename T, typename Check = DefaultCheck>
+class checked_range {
+  public:
+	typedef unsigned64 size_type;
+
+	// data points to the element with index 0 (not lo) of the container.
+	checked_range(T* data, size_type lo, size_type hi, size_type container_size)
+	: data_(data), lo_(lo), hi_(hi) {
+		CheckRange<Check>(lo, hi, container_size);
+	}
+
+	size_type lo() const { return lo_; }
+	size_type hi() const { return hi_; }
+	size_type size() const { return hi_ - lo_; }
+
+	// Indices are the same as in the container, i.e. lo() .. hi()-1.
+	// Not checked: the range itself was validated on construction.
+	T& operator [] (size_type index) const {
+#ifdef SCPP_CHECKED_RANGE_PARANOID
+		SCPP_ASSERT(index >= lo_ && index < hi_,
+			"Index " << index << " must be within [" << lo_ << ", " << hi_ << ")");
+#endif
+		return data_[index];
+	}
+
+	// Accessors
+	T* begin() const { return data_ + lo_; }
+
+	// Returns pointer PAST the last element of the range.
+	T* end() const { return data_ + hi_; }
+
+  private:
+	T*			data_;
+	size_type	lo_, hi_;
+};
+
+template <typename T, typename A, typename C>
+inline checked_range<T, C> make_checked_range(scpp::vector<T, A, C>& v,
+										   unsigned64 lo, unsigned64 hi) {
+	return checked_range<T, C>(v.empty() ? NULL : &v.front(), lo, hi, v.size());
+}
+
+template <typename T, typename A, typename C>
+inline checked_range<const T, C> make_checked_range(const scpp::vector<T, A, C>& v,
+												 unsigned64 lo, unsigned64 hi) {
+	return checked_range<const T, C>(v.empty() ? NULL : &v.front(), lo, hi, v.size());
+}
+
+template <typename T, unsigned N, typename C>
+inline checked_range<T, C> make_checked_range(scpp::array<T, N, C>& a,
+										   unsigned64 lo, unsigned64 hi) {
+	return checked_range<T, C>(a.begin(), lo, hi, N);
+}
+
+template <typename T, unsigned N, typename C>
+inline checked_range<const T, C> make_checked_range(const scpp::array<T, N, C>& a,
+												 unsigned64 lo, unsigned64 hi) {
+	return checked_range<const T, C>(a.begin(), lo, hi, N);
+}
+
+template <typename T, unsigned64 Extent>
+inline checked_range<T> make_checked_range(const scpp::span<T, Extent>& s,
+										   unsigned64 lo, unsigned64 hi) {
+	return checked_range<T>(s.data(), lo, hi, s.size());
+}
+
+// Calls f(i, x[i]) for every i in [lo, hi) with one range check.
+template <typename T, typename C, typename Function>
+inline void for_each_index(const checked_range<T, C>& r, Function f) {
+	T* data = r.begin() - r.lo();
+	for(unsigned64 i=r.lo(); i<r.hi(); ++i)
+		f(i, data[i]);
+}
+
+template <typename T, typename A, typename C, typename Function>
+inline void for_each_index(scpp::vector<T, A, C>& v, unsigned64 lo, unsigned64 hi, Function f) {
+	for_each_index(make_checked_range(v, lo, hi), f);
+}
+
+template <typename T, typename A, typename C, typename Function>
+inline void for_each_index(const scpp::vector<T, A, C>& v, unsigned64 lo, unsigned64 hi, Function f) {
+	for_each_index(make_checked_range(v, lo, hi), f);
+}
+
+template <typename T, unsigned N, typename C, typename Function>
+inline void for_each_index(scpp::array<T, N, C>& a, unsigned64 lo, unsigned64 hi, Function f) {
+	for_each_index(make_checked_range(a, lo, hi), f);
+}
+
+template <typename T, unsigned N, typename C, typename Function>
+inline void for_each_index(const scpp::array<T, N, C>& a, unsigned64 lo, unsigned64 hi, Function f) {
+	for_each_index(make_checked_range(a, lo, hi), f);
+}
+
+template <typename T, unsigned64 Extent, typename Function>
+inline void for_each_index(const scpp::span<T, Extent>& s, unsigned64 lo, unsigned64 hi, Function f) {
+	for_each_index(make_checked_range(s, lo, hi), f);
+}
+
+// Calls f(row, col, m(row, col)) for the block of rows [row_lo, row_hi)
+// and columns [col_lo, col_hi), checking both ranges once.
+// The elements are visited in the memory order of the matrix layout:
+// row by row for RowMajor, column by column for ColMajor.
+template <typename T, typename A, typename C, typename Function>
+inline void for_each_index(scpp::matrix<T, A, C, RowMajor>& m,
+						   unsigned64 row_lo, unsigned64 row_hi,
+						   unsigned64 col_lo, unsigned64 col_hi, Function f) {
+	CheckRange<C>(row_lo, row_hi, m.num_rows());
+	CheckRange<C>(col_lo, col_hi, m.num_cols());
+	if(row_lo == row_hi)
+		return;
+	const unsigned64 stride = m.num_cols();
+	T* row_data = m.row_data(row_lo);
+	for(unsigned64 r=row_lo; r<row_hi; ++r, row_data += stride)
+		for(unsigned64 c=col_lo; c<col_hi; ++c)
+			f(r, c, row_data[c]);
+}
+
+template <typename T, typename A, typename C, typename Function>
+inline void for_each_index(const scpp::matrix<T, A, C, RowMajor>& m,
+						   unsigned64 row_lo, unsigned64 row_hi,
+						   unsigned64 col_lo, unsigned64 col_hi, Function f) {
+	CheckRange<C>(row_lo, row_hi, m.num_rows());
+	CheckRange<C>(col_lo, col_hi, m.num_cols());
+	if(row_lo == row_hi)
+		return;
+	const unsigned64 stride = m.num_cols();
+	const T* row_data = m.row_data(row_lo);
+	for(unsigned64 r=row_lo; r<row_hi; ++r, row_data += stride)
+		for(unsigned64 c=col_lo; c<col_hi; ++c)
+			f(r, c, row_data[c]);
+}
+
+template <typename T, typename A, typename C, typename Function>
+inline void for_each_index(scpp::matrix<T, A, C, ColMajor>& m,
+						   unsigned64 row_lo, unsigned64 row_hi,
+						   unsigned64 col_lo, unsigned64 col_hi, Function f) {
+	CheckRange<C>(row_lo, row_hi, m.num_rows());
+	CheckRange<C>(col_lo, col_hi, m.num_cols());
+	if(col_lo == col_hi)
+		return;
+	const unsigned64 stride = m.num_rows();
+	T* col_data = m.col_data(col_lo);
+	for(unsigned64 c=col_lo; c<col_hi; ++c, col_data += stride)
+		for(unsigned64 r=row_lo; r<row_hi; ++r)
+			f(r, c, col_data[r]);
+}
+
+template <typename T, typename A, typename C, typename Function>
+inline void for_each_index(const scpp::matrix<T, A, C, ColMajor>& m,
+						   unsigned64 row_lo, unsigned64 row_hi,
+						   unsigned64 col_lo, unsigned64 col_hi, Function f) {
+	CheckRange<C>(row_lo, row_hi, m.num_rows());
+	CheckRange<C>(col_lo, col_hi, m.num_cols());
+	if(col_lo == col_hi)
+		return;
+	const unsigned64 stride = m.num_rows();
+	const T* col_data = m.col_data(col_lo);
+	for(unsigned64 c=col_lo; c<col_hi; ++c, col_data += stride)
+		for(unsigned64 r=row_lo; r<row_hi; ++r)
+			f(r, c, col_data[r]);
+}
+
+} // namespace scpp
+
+#endif // __SCPP_RANGE_HPP_INCLUDED__
@@ -14,11 +14,13 @@
 #define __SCPP_REFCOUNTPTR_HPP_INCLUDED__
 
 #include "scpp_assert.hpp"
+#include "scpp_check_policy.hpp"
 
 namespace scpp {
 
 // Reference-counting pointer.  Takes ownership of an object.  Can be copied.
-template <typename T>
+// The checks are controlled by the policy Check (see scpp_check_policy.hpp).
+template <typename T, typename Check = DefaultCheck>
 class RefCountPtr {
   public:
 
@@ -26,11 +28,11 @@ class RefCountPtr {
 		Create(p);	
 	}
 
-	RefCountPtr(const RefCountPtr<T>& rhs) {
+	RefCountPtr(const RefCountPtr<T, Check>& rhs) {
 		Copy(rhs);					
 	}
 
-	RefCountPtr<T>& operator=(const RefCountPtr<T>& rhs) {
+	RefCountPtr<T, Check>& operator=(const RefCountPtr<T, Check>& rhs) {
 		if(ptr_ != rhs.ptr_) {
 			Kill();
 			Copy(rhs);
@@ -39,7 +41,7 @@ class RefCountPtr {
 		return *this;
 	}
 
-	RefCountPtr<T>& operator=(T* p) {						
+	RefCountPtr<T, Check>& operator=(T* p) {						
 		if(ptr_ != p) {
 			Kill();
 			Create(p);
@@ -55,12 +57,12 @@ class RefCountPtr {
 	T* Get() const { return ptr_; }
 
 	T* operator->() const {
-		SCPP_TEST_ASSERT(ptr_ != NULL, "Attempt to use operator -> on NULL pointer.");
+		SCPP_CHECK(Check, ptr_ != NULL, "Attempt to use operator -> on NULL pointer.");
 		return ptr_;
 	}
 
 	T& operator* () const { 
-		SCPP_TEST_ASSERT(ptr_ != NULL, "Attempt to use operator * on NULL pointer.");
+		SCPP_CHECK(Check, ptr_ != NULL, "Attempt to use operator * on NULL pointer.");
 		return *ptr_;
 	}
 
@@ -78,7 +80,7 @@ private:
 		}
 	}
 
-	void Copy(const RefCountPtr<T>& rhs) {
+	void Copy(const RefCountPtr<T, Check>& rhs) {
 		ptr_ = rhs.ptr_;
 		count_ = rhs.count_;
 		if(count_ != NULL)
@@ -14,11 +14,13 @@
 #define __SCPP_SCOPEDPTR_HPP_INCLUDED__
 
 #include "scpp_assert.hpp"
+#include "scpp_check_policy.hpp"
 
 namespace scpp {
 
 // Scoped pointer, takes ownership of an object, could not be copied.
-template <typename T>
+// The checks are controlled by the policy Check (see scpp_check_policy.hpp).
+template <typename T, typename Check = DefaultCheck>
 class ScopedPtr {
   public:
 
@@ -26,7 +28,7 @@ class ScopedPtr {
 	: ptr_(p) {
 	}
 
-	ScopedPtr<T>& operator=(T* p) {						
+	ScopedPtr<T, Check>& operator=(T* p) {						
 		if(ptr_ != p)
 		{
 			delete ptr_;
@@ -46,12 +48,12 @@ class ScopedPtr {
 
 	T* operator->() const
 	{						
-		SCPP_TEST_ASSERT(ptr_ != NULL, "Attempt to use operator -> on NULL pointer.");
+		SCPP_CHECK(Check, ptr_ != NULL, "Attempt to use operator -> on NULL pointer.");
 		return ptr_;
 	}
 
 	T& operator* () const { 
-		SCPP_TEST_ASSERT(ptr_ != NULL, "Attempt to use operator * on NULL pointer.");
+		SCPP_CHECK(Check, ptr_ != NULL, "Attempt to use operator * on NULL pointer.");
 		return *ptr_;
 	}
 	
@@ -66,8 +68,8 @@ private:
 	T*	ptr_;
 
 	// Copy is prohibited:
-	ScopedPtr(const ScopedPtr<T>& rhs);
-	ScopedPtr<T>& operator=(const ScopedPtr<T>& rhs);
+	ScopedPtr(const ScopedPtr<T, Check>& rhs);
+	ScopedPtr<T, Check>& operator=(const ScopedPtr<T, Check>& rhs);
 };
 
 } // namespace scpp
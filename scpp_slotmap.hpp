@@ -0,0 +1,236 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#ifndef __SCPP_SLOTMAP_HPP_INCLUDED__
+#define __SCPP_SLOTMAP_HPP_INCLUDED__
+
+#include <utility>	// move
+#include <vector>
+#include "scpp_assert.hpp"
+
+namespace scpp {
+
+template <typename T> class SlotMap;
+
+// Handle to an object stored in a SlotMap<T>: 32-bit slot index plus
+// 32-bit generation. Unlike Ptr<T>, a handle knows when its object
+// has been erased, so a dangling handle can be detected on use.
+template <typename T>
+class Handle {
+  public:
+	// Creates a null handle, which never refers to any object.
+	Handle()
+	: index_(NULL_INDEX), generation_(0) {
+	}
+
+	bool IsNull() const { return index_ == NULL_INDEX; }
+
+	unsigned Index() const { return index_; }
+	unsigned Generation() const { return generation_; }
+
+	bool operator ==(const Handle<T>& that) const {
+		return index_ == that.index_ && generation_ == that.generation_;
+	}
+
+	bool operator !=(const Handle<T>& that) const {
+		return !(*this == that);
+	}
+
+  private:
+	friend class SlotMap<T>;
+
+	enum { NULL_INDEX = 0xFFFFFFFFu };
+
+	Handle(unsigned index, unsigned generation)
+	: index_(index), generation_(generation) {
+	}
+
+	unsigned index_;
+	unsigned generation_;
+};
+
+/*
+	Generational slot map.
+	Features:
+		Objects are stored densely in one contiguous array,
+			so iteration over begin() .. end() is cache-friendly.
+		Insert, Erase and lookup by Handle are O(1).
+		Lookup by a handle of an erased object (use-after-free) is caught
+			by SCPP_TEST_ASSERT, the same way as an out-of-range index
+			in scpp::vector. Find(), Contains() and Erase() check always.
+		Erase moves the last object into the hole, so the order of
+			objects in begin() .. end() is not preserved.
+	Requires C++11 (std::move).
+*/
+template <typename T>
+class SlotMap {
+  public:
+	typedef unsigned size_type;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+
+	SlotMap()
+	: free_head_(NO_SLOT), free_tail_(NO_SLOT) {
+	}
+
+	// Note: we do not provide a copy-ctor and assignment operator.
+	// we rely on default versions of these methods generated by the compiler.
+
+	size_type Size() const { return (size_type)data_.size(); }
+	bool IsEmpty() const { return data_.empty(); }
+
+	void Reserve(size_type n) {
+		data_.reserve(n);
+		data_slot_.reserve(n);
+		slots_.reserve(n);
+	}
+
+	// Stores a copy of value and returns a handle to it.
+	Handle<T> Insert(const T& value) {
+		unsigned slot_index = AllocateSlot();
+		Slot& slot = slots_[slot_index];
+		slot.dense_index = (unsigned)data_.size();
+		data_.push_back(value);
+		data_slot_.push_back(slot_index);
+		++slot.generation;	// becomes odd: slot is occupied
+		return Handle<T>(slot_index, slot.generation);
+	}
+
+	// Destroys the object referred to by h; h and all its copies become stale.
+	// Returns false and does nothing if h is already stale, e.g. erased twice.
+	bool Erase(Handle<T> h) {
+		if(!Contains(h))
+			return false;
+
+		Slot& slot = slots_[h.index_];
+		unsigned hole = slot.dense_index;
+		unsigned last = (unsigned)data_.size() - 1;
+		if(hole != last) {
+			data_[hole] = std::move(data_[last]);
+			data_slot_[hole] = data_slot_[last];
+			slots_[data_slot_[hole]].dense_index = hole;
+		}
+		data_.pop_back();
+		data_slot_.pop_back();
+
+		++slot.generation;	// becomes even: slot is free
+		ReleaseSlot(h.index_);
+		return true;
+	}
+
+	// Erases all objects. All handles issued so far become stale.
+	void Clear() {
+		for(size_type i=0; i<data_slot_.size(); ++i) {
+			++slots_[data_slot_[i]].generation;
+			ReleaseSlot(data_slot_[i]);
+		}
+		data_.clear();
+		data_slot_.clear();
+	}
+
+	// Returns true if h refers to an object that has not been erased.
+	bool Contains(Handle<T> h) const {
+		return h.index_ < slots_.size()
+			&& slots_[h.index_].generation == h.generation_;
+	}
+
+	// Returns pointer to the object, or NULL if the handle is stale.
+	T* Find(Handle<T> h) {
+		return Contains(h) ? &data_[slots_[h.index_].dense_index] : NULL;
+	}
+
+	const T* Find(Handle<T> h) const {
+		return Contains(h) ? &data_[slots_[h.index_].dense_index] : NULL;
+	}
+
+	T& operator [] (Handle<T> h) {
+		SCPP_TEST_ASSERT(Contains(h),
+			"Attempt to use a stale handle: slot " << h.index_
+			<< ", generation " << h.generation_);
+		return data_[slots_[h.index_].dense_index];
+	}
+
+	const T& operator [] (Handle<T> h) const {
+		SCPP_TEST_ASSERT(Contains(h),
+			"Attempt to use a stale handle: slot " << h.index_
+			<< ", generation " << h.generation_);
+		return data_[slots_[h.index_].dense_index];
+	}
+
+	// Returns handle of the object at position dense_index in begin() .. end().
+	Handle<T> HandleAt(size_type dense_index) const {
+		SCPP_TEST_ASSERT(dense_index < data_.size(),
+			"Index " << dense_index << " must be less than " << data_.size());
+		unsigned slot_index = data_slot_[dense_index];
+		return Handle<T>(slot_index, slots_[slot_index].generation);
+	}
+
+	// Accessors to the dense storage.
+	iterator begin() { return data_.empty() ? NULL : &data_[0]; }
+	const_iterator begin() const { return data_.empty() ? NULL : &data_[0]; }
+
+	// Returns pointer PAST the last object.
+	iterator end() { return begin() + data_.size(); }
+	const_iterator end() const { return begin() + data_.size(); }
+
+  private:
+	enum { NO_SLOT = 0xFFFFFFFFu, MAX_GENERATION = 0xFFFFFFFFu };
+
+	struct Slot {
+		unsigned dense_index;	// position in data_ while occupied,
+								// next free slot while free
+		unsigned generation;	// odd while occupied, even while free
+	};
+
+	std::vector<T>			data_;		// dense objects
+	std::vector<unsigned>	data_slot_;	// slot index of each object in data_
+	std::vector<Slot>		slots_;
+	unsigned				free_head_, free_tail_;
+
+	unsigned AllocateSlot() {
+		if(free_head_ == NO_SLOT) {
+			SCPP_ASSERT(slots_.size() < NO_SLOT, "SlotMap is full");
+			Slot slot;
+			slot.dense_index = NO_SLOT;
+			slot.generation = 0;
+			slots_.push_back(slot);
+			return (unsigned)slots_.size() - 1;
+		}
+		unsigned slot_index = free_head_;
+		free_head_ = slots_[slot_index].dense_index;
+		if(free_head_ == NO_SLOT)
+			free_tail_ = NO_SLOT;
+		return slot_index;
+	}
+
+	// Free slots are reused in FIFO order, so that a generation
+	// grows as slowly as possible.
+	void ReleaseSlot(unsigned slot_index) {
+		Slot& slot = slots_[slot_index];
+		slot.dense_index = NO_SLOT;
+
+		// A slot whose generation is about to wrap around is retired
+		// forever, otherwise a very old handle could become valid again.
+		if(slot.generation >= MAX_GENERATION - 1)
+			return;
+
+		if(free_tail_ == NO_SLOT)
+			free_head_ = slot_index;
+		else
+			slots_[free_tail_].dense_index = slot_index;
+		free_tail_ = slot_index;
+	}
+};
+
+} // namespace scpp
+
+#endif // __SCPP_SLOTMAP_HPP_INCLUDED__
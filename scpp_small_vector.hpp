@@ -0,0 +1,322 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#ifndef __SCPP_SMALL_VECTOR_HPP_INCLUDED__
+#define __SCPP_SMALL_VECTOR_HPP_INCLUDED__
+
+#include <algorithm>	// rotate, move
+#include <new>			// operator new, placement new
+#include <ostream>
+#include <type_traits>	// enable_if, is_integral
+#include <utility>		// move, forward, move_if_noexcept
+
+#include "scpp_assert.hpp"
+
+namespace scpp {
+
+/*
+	Vector with a small buffer optimization.
+	Features:
+		Up to N elements are stored inside the object itself,
+			no heap allocation is made until the size exceeds N.
+		Beyond N elements the data is moved to the heap,
+			the growth policy is the same as in std::vector (doubling).
+		Same temporary sanity checks in the operators [] as in scpp::vector.
+		Interface is a subset of the std::vector interface,
+			iterators are plain pointers.
+	As with std::vector, any operation that increases the size
+	may invalidate the iterators and references to the elements.
+	Requires C++11 (move semantics).
+*/
+template <typename T, unsigned N>
+class small_vector {
+  public:
+	typedef unsigned	size_type;
+	typedef T			value_type;
+	typedef T*			iterator;
+	typedef const T*	const_iterator;
+	typedef T&			reference;
+	typedef const T&	const_reference;
+
+	static_assert(N > 0, "small_vector must have inline capacity of at least 1");
+
+	// Most commonly used constructors:
+	small_vector()
+	: begin_(InlineData()), size_(0), capacity_(N)
+	{}
+
+	explicit small_vector( size_type n )
+	: begin_(InlineData()), size_(0), capacity_(N) {
+		resize(n);
+	}
+
+	small_vector( size_type n, const T& value )
+	: begin_(InlineData()), size_(0), capacity_(N) {
+		resize(n, value);
+	}
+
+	template <class InputIterator, class = typename std::enable_if<
+		!std::is_integral<InputIterator>::value>::type>
+	small_vector( InputIterator first, InputIterator last )
+	: begin_(InlineData()), size_(0), capacity_(N) {
+		for( ; first != last; ++first)
+			push_back(*first);
+	}
+
+	small_vector( const small_vector& that )
+	: begin_(InlineData()), size_(0), capacity_(N) {
+		reserve(that.size_);
+		for(size_type i=0; i<that.size_; ++i)
+			new(begin_ + i) T(that.begin_[i]);
+		size_ = that.size_;
+	}
+
+	small_vector( small_vector&& that )
+	: begin_(InlineData()), size_(0), capacity_(N) {
+		MoveFrom(that);
+	}
+
+	small_vector& operator = ( const small_vector& that ) {
+		if(this != &that) {
+			clear();
+			reserve(that.size_);
+			for(size_type i=0; i<that.size_; ++i)
+				new(begin_ + i) T(that.begin_[i]);
+			size_ = that.size_;
+		}
+		return *this;
+	}
+
+	small_vector& operator = ( small_vector&& that ) {
+		if(this != &that) {
+			clear();
+			FreeHeap();
+			MoveFrom(that);
+		}
+		return *this;
+	}
+
+	~small_vector() {
+		clear();
+		FreeHeap();
+	}
+
+	size_type size() const { return size_; }
+	size_type capacity() const { return capacity_; }
+	bool empty() const { return size_ == 0; }
+
+	// Returns true while the elements are stored inside the object.
+	bool is_inline() const { return begin_ == InlineData(); }
+
+	T& operator [] (size_type index) {
+		SCPP_TEST_ASSERT(index < size_,
+			"Index " << index << " must be less than " << size_);
+		return begin_[index];
+	}
+
+	const T& operator [] (size_type index) const {
+		SCPP_TEST_ASSERT(index < size_,
+			"Index " << index << " must be less than " << size_);
+		return begin_[index];
+	}
+
+	T& front() {
+		SCPP_TEST_ASSERT(size_ > 0, "front() called on empty small_vector");
+		return begin_[0];
+	}
+
+	const T& front() const {
+		SCPP_TEST_ASSERT(size_ > 0, "front() called on empty small_vector");
+		return begin_[0];
+	}
+
+	T& back() {
+		SCPP_TEST_ASSERT(size_ > 0, "back() called on empty small_vector");
+		return begin_[size_ - 1];
+	}
+
+	const T& back() const {
+		SCPP_TEST_ASSERT(size_ > 0, "back() called on empty small_vector");
+		return begin_[size_ - 1];
+	}
+
+	// Accessors
+	T* data() { return begin_; }
+	const T* data() const { return begin_; }
+
+	iterator begin() { return begin_; }
+	const_iterator begin() const { return begin_; }
+
+	// Returns pointer PAST the last element.
+	iterator end() { return begin_ + size_; }
+	const_iterator end() const { return begin_ + size_; }
+
+	void reserve(size_type n) {
+		if(n > capacity_)
+			Reallocate(n);
+	}
+
+	void push_back(const T& value) { emplace_back(value); }
+	void push_back(T&& value) { emplace_back(std::move(value)); }
+
+	template <typename... Args>
+	T& emplace_back(Args&&... args) {
+		if(size_ == capacity_) {
+			// The new element is constructed before the old ones are moved,
+			// so that args may refer to an element of this vector.
+			size_type new_capacity = NextCapacity(size_ + 1);
+			T* p = Allocate(new_capacity);
+			new(p + size_) T(std::forward<Args>(args)...);
+			MoveElements(p);
+			FreeHeap();
+			begin_ = p;
+			capacity_ = new_capacity;
+		} else {
+			new(begin_ + size_) T(std::forward<Args>(args)...);
+		}
+		return begin_[size_++];
+	}
+
+	void pop_back() {
+		SCPP_TEST_ASSERT(size_ > 0, "pop_back() called on empty small_vector");
+		begin_[--size_].~T();
+	}
+
+	// Inserts value before pos, returns iterator to the inserted element.
+	iterator insert(const_iterator pos, const T& value) {
+		size_type offset = CheckedOffset(pos);
+		push_back(value);
+		std::rotate(begin_ + offset, begin_ + size_ - 1, begin_ + size_);
+		return begin_ + offset;
+	}
+
+	// Removes element at pos, returns iterator to the following element.
+	iterator erase(const_iterator pos) {
+		size_type offset = CheckedOffset(pos);
+		SCPP_TEST_ASSERT(offset < size_, "Attempt to erase end() of small_vector");
+		std::move(begin_ + offset + 1, begin_ + size_, begin_ + offset);
+		pop_back();
+		return begin_ + offset;
+	}
+
+	iterator erase(const_iterator first, const_iterator last) {
+		size_type from = CheckedOffset(first);
+		size_type to = CheckedOffset(last);
+		SCPP_TEST_ASSERT(from <= to, "Wrong range [" << from << ", " << to << ")");
+		std::move(begin_ + to, begin_ + size_, begin_ + from);
+		size_type new_size = size_ - (to - from);
+		while(size_ > new_size)
+			pop_back();
+		return begin_ + from;
+	}
+
+	void resize(size_type n) {
+		reserve(n);
+		while(size_ > n)
+			pop_back();
+		for( ; size_ < n; ++size_)
+			new(begin_ + size_) T();
+	}
+
+	void resize(size_type n, const T& value) {
+		while(size_ > n)
+			pop_back();
+		while(size_ < n)
+			push_back(value);
+	}
+
+	// Destroys all elements, keeps the capacity.
+	void clear() {
+		while(size_ > 0)
+			begin_[--size_].~T();
+	}
+
+  private:
+	T*			begin_;		// InlineData() or heap
+	size_type	size_;
+	size_type	capacity_;
+	alignas(T) unsigned char inline_[N * sizeof(T)];
+
+	T* InlineData() { return reinterpret_cast<T*>(inline_); }
+	const T* InlineData() const { return reinterpret_cast<const T*>(inline_); }
+
+	static T* Allocate(size_type n) {
+		return static_cast<T*>(::operator new(sizeof(T) * (size_t)n));
+	}
+
+	void FreeHeap() {
+		if(!is_inline()) {
+			::operator delete(begin_);
+			begin_ = InlineData();
+			capacity_ = N;
+		}
+	}
+
+	size_type NextCapacity(size_type needed) const {
+		size_type doubled = 2 * capacity_;
+		return doubled > needed ? doubled : needed;
+	}
+
+	// Moves size_ elements to p and destroys the originals.
+	void MoveElements(T* p) {
+		for(size_type i=0; i<size_; ++i) {
+			new(p + i) T(std::move_if_noexcept(begin_[i]));
+			begin_[i].~T();
+		}
+	}
+
+	void Reallocate(size_type new_capacity) {
+		T* p = Allocate(new_capacity);
+		MoveElements(p);
+		FreeHeap();
+		begin_ = p;
+		capacity_ = new_capacity;
+	}
+
+	// Requires this to be empty and inline.
+	void MoveFrom(small_vector& that) {
+		if(that.is_inline()) {
+			for(size_type i=0; i<that.size_; ++i)
+				new(begin_ + i) T(std::move(that.begin_[i]));
+			size_ = that.size_;
+			that.clear();
+		} else {
+			begin_ = that.begin_;
+			size_ = that.size_;
+			capacity_ = that.capacity_;
+			that.begin_ = that.InlineData();
+			that.size_ = 0;
+			that.capacity_ = N;
+		}
+	}
+
+	size_type CheckedOffset(const_iterator pos) const {
+		SCPP_TEST_ASSERT(begin_ <= pos && pos <= begin_ + size_,
+			"Iterator does not point into this small_vector");
+		return (size_type)(pos - begin_);
+	}
+};
+} // namespace scpp
+
+
+template <typename T, unsigned N>
+inline
+std::ostream& operator << (std::ostream& os, const scpp::small_vector<T, N>& v) {
+	for(unsigned i=0; i<v.size(); ++i) {
+		os << v[i];
+		if( i + 1 < v.size() )
+			os << " ";
+	}
+	return os;
+}
+
+#endif // __SCPP_SMALL_VECTOR_HPP_INCLUDED__
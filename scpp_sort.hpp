@@ -0,0 +1,359 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#ifndef __SCPP_SORT_HPP_INCLUDED__
+#define __SCPP_SORT_HPP_INCLUDED__
+
+#include <algorithm>	// min
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "scpp_assert.hpp"
+#include "scpp_date.hpp"
+#include "scpp_types.hpp"
+#include "scpp_vector.hpp"
+
+/*
+	Sorting and searching of scpp::vector columns of Date, Int64 and other
+	integer TNumber types. These types are plain integers underneath,
+	so instead of comparing with CompareTo() the algorithms below work
+	on an unsigned integer key of the same order (see RadixKey).
+	Features:
+		radix_sort()	-- stable LSD radix sort, 8 bits per pass; passes in
+						   which all keys have the same byte are skipped
+						   (e.g. the high bytes of dates of a few years).
+						   Sorts keys alone or keys with a payload vector.
+		lower_bound(), upper_bound()
+						-- binary search without unpredictable branches,
+						   returns an index.
+		merge()			-- stable merge of two sorted vectors.
+		unique()		-- removes consecutive duplicates.
+	radix_sort() and merge() split large inputs between num_threads
+	threads (0 means one per hardware thread).
+
+	Typical use:
+
+		scpp::vector<scpp::Date> dates;
+		...
+		scpp::radix_sort(dates);
+		scpp::unique(dates);
+		unsigned64 i = scpp::lower_bound(dates, scpp::Date(20120101));
+
+	Requires C++11 (threads).
+*/
+namespace scpp {
+
+enum { SORT_MIN_PARALLEL_SIZE = 1 << 16 };	// smaller inputs use one thread
+
+// Order-preserving unsigned key of an integer: the sign bit is flipped,
+// so that negative numbers come before positive ones.
+template <typename I>
+struct IntegerRadixKey {
+	typedef typename std::make_unsigned<I>::type type;
+
+	static type Get(I x) {
+		return std::is_signed<I>::value
+			? type(x) ^ (type(1) << (sizeof(type) * 8 - 1))
+			: type(x);
+	}
+};
+
+// Key of the types that radix_sort() and the searches accept.
+template <typename T>
+struct RadixKey;
+
+template <> struct RadixKey<int> : IntegerRadixKey<int> {};
+template <> struct RadixKey<unsigned> : IntegerRadixKey<unsigned> {};
+template <> struct RadixKey<int64> : IntegerRadixKey<int64> {};
+template <> struct RadixKey<unsigned64> : IntegerRadixKey<unsigned64> {};
+
+template <typename I, typename P>
+struct RadixKey<TNumber<I, P> > {
+	typedef typename IntegerRadixKey<I>::type type;
+
+	static type Get(const TNumber<I, P>& x) { return IntegerRadixKey<I>::Get(x); }
+};
+
+// Dates are ordered by the number of days, invalid dates come first.
+template <>
+struct RadixKey<Date> {
+	typedef unsigned type;
+
+	static type Get(const Date& d) { return IntegerRadixKey<int>::Get(d.Data()); }
+};
+
+namespace detail {
+
+struct NoPayload {};
+
+inline unsigned SortThreads(unsigned num_threads, unsigned64 n) {
+	if(num_threads == 0)
+		num_threads = std::max(1u, std::thread::hardware_concurrency());
+	return (unsigned)std::min<unsigned64>(num_threads, n / (SORT_MIN_PARALLEL_SIZE / 4) + 1);
+}
+
+// Runs f(t) for t in [0, num_threads), f(0) in the calling thread.
+template <typename F>
+void RunThreads(unsigned num_threads, F f) {
+	std::vector<std::thread> threads;
+	for(unsigned t=1; t<num_threads; ++t)
+		threads.push_back(std::thread(f, t));
+	f(0);
+	for(unsigned t=0; t<threads.size(); ++t)
+		threads[t].join();
+}
+
+template <typename P>
+inline void MovePayload(P* dst, unsigned64 to, const P* src, unsigned64 from) {
+	dst[to] = src[from];
+}
+
+inline void MovePayload(NoPayload*, unsigned64, const NoPayload*, unsigned64) {
+}
+
+// LSD radix sort of keys[0..n) with payload[0..n) moved along.
+// The tmp buffers must have n elements. Returns true if the sorted
+// result is in the tmp buffers (after an odd number of passes).
+template <typename T, typename P>
+bool RadixSort(T* keys, T* tmp_keys, P* payload, P* tmp_payload,
+			   unsigned64 n, unsigned num_threads) {
+	typedef RadixKey<T> Key;
+	const unsigned passes = sizeof(typename Key::type);
+	bool in_tmp = false;
+	if(n < 2)
+		return in_tmp;
+
+	num_threads = n < SORT_MIN_PARALLEL_SIZE ? 1 : SortThreads(num_threads, n);
+	const unsigned64 chunk = (n + num_threads - 1) / num_threads;
+	std::vector<unsigned64> counts(num_threads * 256);
+
+	for(unsigned pass=0; pass<passes; ++pass) {
+		const unsigned shift = pass * 8;
+
+		// Histogram of the byte of every chunk.
+		RunThreads(num_threads, [&](unsigned t) {
+			const T* src = keys;
+			const unsigned sh = shift;
+			unsigned64 count[256] = {};
+			unsigned64 end = std::min(n, (t + 1) * chunk);
+			for(unsigned64 i=t*chunk; i<end; ++i)
+				++count[(Key::Get(src[i]) >> sh) & 0xFF];
+			std::copy(count, count + 256, &counts[t * 256]);
+		});
+
+		// Skip the pass if all keys have the same byte.
+		unsigned64 same = 0;
+		for(unsigned t=0; t<num_threads; ++t)
+			same += counts[t * 256 + ((Key::Get(keys[0]) >> shift) & 0xFF)];
+		if(same == n)
+			continue;
+
+		// Start of every (byte, chunk): the chunks of one byte go in order,
+		// which keeps the sort stable.
+		unsigned64 offset = 0;
+		for(unsigned b=0; b<256; ++b) {
+			for(unsigned t=0; t<num_threads; ++t) {
+				unsigned64 c = counts[t * 256 + b];
+				counts[t * 256 + b] = offset;
+				offset += c;
+			}
+		}
+
+		RunThreads(num_threads, [&](unsigned t) {
+			// Local copies, so that the compiler knows the stores
+			// into dst do not change them.
+			const T* src = keys;
+			T* dst = tmp_keys;
+			const P* src_payload = payload;
+			P* dst_payload = tmp_payload;
+			unsigned64 position[256];
+			std::copy(&counts[t * 256], &counts[t * 256] + 256, position);
+			const unsigned sh = shift;
+			unsigned64 end = std::min(n, (t + 1) * chunk);
+			for(unsigned64 i=t*chunk; i<end; ++i) {
+				unsigned64 to = position[(Key::Get(src[i]) >> sh) & 0xFF]++;
+				dst[to] = src[i];
+				MovePayload(dst_payload, to, src_payload, i);
+			}
+		});
+		std::swap(keys, tmp_keys);
+		std::swap(payload, tmp_payload);
+		in_tmp = !in_tmp;
+	}
+	return in_tmp;
+}
+
+// Index of the first element of the sorted data[0..n) with the key
+// not less than key (upper = false) or greater than key (upper = true).
+template <typename T>
+unsigned64 BranchlessBound(const T* data, unsigned64 n,
+						   typename RadixKey<T>::type key, bool upper) {
+	if(n == 0)
+		return 0;
+	const T* base = data;
+	while(n > 1) {
+		unsigned64 half = n / 2;
+		typename RadixKey<T>::type k = RadixKey<T>::Get(base[half]);
+		// compiles to a conditional move, not a branch
+		base = (upper ? k <= key : k < key) ? base + half : base;
+		n -= half;
+	}
+	typename RadixKey<T>::type k = RadixKey<T>::Get(*base);
+	return (base - data) + (upper ? k <= key : k < key);
+}
+
+// Number of elements of a taken among the first d elements of the stable
+// merge of the sorted a[0..na) and b[0..nb).
+template <typename T>
+unsigned64 MergeSplit(const T* a, unsigned64 na, const T* b, unsigned64 nb, unsigned64 d) {
+	unsigned64 lo = d > nb ? d - nb : 0;
+	unsigned64 hi = std::min(d, na);
+	while(lo < hi) {
+		unsigned64 i = (lo + hi) / 2;
+		if(RadixKey<T>::Get(a[i]) <= RadixKey<T>::Get(b[d - i - 1]))
+			lo = i + 1;
+		else
+			hi = i;
+	}
+	return lo;
+}
+
+template <typename T>
+void MergeSequential(const T* a, unsigned64 na, const T* b, unsigned64 nb, T* out) {
+	unsigned64 i = 0, j = 0, k = 0;
+	while(i < na && j < nb) {
+		bool take_b = RadixKey<T>::Get(b[j]) < RadixKey<T>::Get(a[i]);
+		out[k++] = take_b ? b[j] : a[i];
+		j += take_b;
+		i += !take_b;
+	}
+	for(; i<na; ++i)
+		out[k++] = a[i];
+	for(; j<nb; ++j)
+		out[k++] = b[j];
+}
+} // namespace detail
+
+// Sorts v by RadixKey, equal elements keep their order.
+template <typename T, typename A, typename C>
+void radix_sort(scpp::vector<T, A, C>& v, unsigned num_threads = 1) {
+	if(v.size() < 2)
+		return;
+	std::vector<T> tmp(v.size());
+	if(detail::RadixSort(&v[0], &tmp[0], (detail::NoPayload*)NULL, (detail::NoPayload*)NULL,
+						 v.size(), num_threads))
+		std::copy(tmp.begin(), tmp.end(), v.begin());
+}
+
+// Sorts keys by RadixKey and moves payload[i] along with keys[i],
+// equal keys keep their order.
+template <typename T, typename A, typename C, typename P, typename A2, typename C2>
+void radix_sort(scpp::vector<T, A, C>& keys, scpp::vector<P, A2, C2>& payload,
+				unsigned num_threads = 1) {
+	SCPP_TEST_ASSERT(keys.size() == payload.size(),
+		"Number of keys " << keys.size() << " differs from payload size " << payload.size());
+	if(keys.size() < 2)
+		return;
+	std::vector<T> tmp_keys(keys.size());
+	std::vector<P> tmp_payload(payload.size());
+	if(detail::RadixSort(&keys[0], &tmp_keys[0], &payload[0], &tmp_payload[0],
+						 keys.size(), num_threads)) {
+		std::copy(tmp_keys.begin(), tmp_keys.end(), keys.begin());
+		std::copy(tmp_payload.begin(), tmp_payload.end(), payload.begin());
+	}
+}
+
+// Index of the first element of the sorted v not less than value,
+// v.size() if there is none.
+template <typename T, typename A, typename C>
+unsigned64 lower_bound(const scpp::vector<T, A, C>& v, const T& value) {
+	return detail::BranchlessBound(v.empty() ? NULL : &v[0], v.size(),
+								   RadixKey<T>::Get(value), false);
+}
+
+// Index of the first element of the sorted v greater than value,
+// v.size() if there is none.
+template <typename T, typename A, typename C>
+unsigned64 upper_bound(const scpp::vector<T, A, C>& v, const T& value) {
+	return detail::BranchlessBound(v.empty() ? NULL : &v[0], v.size(),
+								   RadixKey<T>::Get(value), true);
+}
+
+// Merges the sorted a and b into out, the elements of a go first
+// among equal ones. out must not be a or b.
+template <typename T, typename A, typename C, typename A2, typename C2, typename A3, typename C3>
+void merge(const scpp::vector<T, A, C>& a, const scpp::vector<T, A2, C2>& b,
+		   scpp::vector<T, A3, C3>& out, unsigned num_threads = 1) {
+	SCPP_TEST_ASSERT((const void*)&out != (const void*)&a && (const void*)&out != (const void*)&b,
+		"Output of merge() must not be one of its inputs");
+	const unsigned64 na = a.size(), nb = b.size(), n = na + nb;
+	out.resize(n);
+	if(n == 0)
+		return;
+	const T* pa = na == 0 ? NULL : &a[0];
+	const T* pb = nb == 0 ? NULL : &b[0];
+	T* po = &out[0];
+
+	num_threads = n < SORT_MIN_PARALLEL_SIZE ? 1 : detail::SortThreads(num_threads, n);
+	// Every thread merges the part of the output [d0, d1) from the parts
+	// of a and b found by binary search ("merge path").
+	detail::RunThreads(num_threads, [&](unsigned t) {
+		unsigned64 d0 = n * t / num_threads, d1 = n * (t + 1) / num_threads;
+		unsigned64 i0 = detail::MergeSplit(pa, na, pb, nb, d0);
+		unsigned64 i1 = detail::MergeSplit(pa, na, pb, nb, d1);
+		detail::MergeSequential(pa + i0, i1 - i0, pb + (d0 - i0), (d1 - i1) - (d0 - i0), po + d0);
+	});
+}
+
+// Removes consecutive elements with equal keys, keeping the first one,
+// e.g. all duplicates of a sorted vector. Returns the new size.
+template <typename T, typename A, typename C>
+unsigned64 unique(scpp::vector<T, A, C>& v) {
+	if(v.size() < 2)
+		return v.size();
+	T* data = &v[0];
+	unsigned64 k = 1;
+	for(unsigned64 i=1, n=v.size(); i<n; ++i) {
+		data[k] = data[i];
+		k += RadixKey<T>::Get(data[i]) != RadixKey<T>::Get(data[k - 1]);
+	}
+	v.resize(k);
+	return k;
+}
+
+// Same as above for keys with payload: payload[i] is kept or removed
+// together with keys[i].
+template <typename T, typename A, typename C, typename P, typename A2, typename C2>
+unsigned64 unique(scpp::vector<T, A, C>& keys, scpp::vector<P, A2, C2>& payload) {
+	SCPP_TEST_ASSERT(keys.size() == payload.size(),
+		"Number of keys " << keys.size() << " differs from payload size " << payload.size());
+	if(keys.size() < 2)
+		return keys.size();
+	T* data = &keys[0];
+	P* pay = &payload[0];
+	unsigned64 k = 1;
+	for(unsigned64 i=1, n=keys.size(); i<n; ++i) {
+		if(RadixKey<T>::Get(data[i]) != RadixKey<T>::Get(data[k - 1])) {
+			data[k] = data[i];
+			pay[k] = pay[i];
+			++k;
+		}
+	}
+	keys.resize(k);
+	payload.resize(k);
+	return k;
+}
+
+} // namespace scpp
+
+#endif // __SCPP_SORT_HPP_INCLUDED__
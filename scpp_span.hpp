@@ -0,0 +1,227 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#ifndef __SCPP_SPAN_HPP_INCLUDED__
+#define __SCPP_SPAN_HPP_INCLUDED__
+
+#include <ostream>
+#include <type_traits>	// enable_if, is_convertible
+
+#include "scpp_assert.hpp"
+#include "scpp_types.hpp"
+#include "scpp_array.hpp"
+#include "scpp_vector.hpp"
+#include "scpp_matrix.hpp"
+
+namespace scpp {
+
+// Extent of a span whose size is known only at run time.
+const unsigned64 dynamic_extent = ~0ULL;
+
+namespace detail {
+
+// Defined only if an array of From could be viewed as an array of To,
+// i.e. the types differ at most by an added const or volatile (the rule
+// of std::span). A span<Base> of Derived objects would index them with
+// the wrong stride, and span<char> of const char would drop the const.
+template <typename From, typename To>
+struct EnableIfSpanConvertible
+: std::enable_if<std::is_convertible<From(*)[], To(*)[]>::value> {
+};
+} // namespace detail
+
+/*
+	Non-owning view of a contiguous sequence of objects.
+	Features:
+		Could be built from scpp::vector, scpp::array, a raw range
+			and a matrix row (see row_span() below) without copying.
+		Same temporary sanity checks in the operators [] and in subspan()
+			as in scpp::vector, with 64-bit sizes.
+		span<T> has its size set at run time,
+			span<T, N> has the size N fixed at compile time.
+	The span does not own the data: it must not outlive the container
+	it was built from, nor be used after the container is resized.
+	A span of a temporary vector or array does not compile, nor does
+	a conversion that drops const or changes the element type.
+	Requires C++11.
+*/
+template <typename T, unsigned64 Extent = dynamic_extent>
+class span {
+  public:
+	typedef unsigned64	size_type;
+	typedef T			element_type;
+	typedef T*			iterator;
+
+	// Empty span, only available for the dynamic extent.
+	span()
+	: data_(NULL), size_(0) {
+		static_assert(Extent == dynamic_extent || Extent == 0,
+			"span of a fixed non-zero size could not be empty");
+	}
+
+	span(T* data, size_type size)
+	: data_(data), size_(size) {
+		CheckExtent();
+	}
+
+	// Range [first, last)
+	span(T* first, T* last)
+	: data_(first), size_(0) {
+		SCPP_TEST_ASSERT(first <= last, "Wrong range: last is before first");
+		size_ = (size_type)(last - first);
+		CheckExtent();
+	}
+
+	template <typename U, typename A, typename C,
+			  typename = typename detail::EnableIfSpanConvertible<U, T>::type>
+	span(scpp::vector<U, A, C>& v)
+	: data_(v.empty() ? NULL : &v.front()), size_(v.size()) {
+		CheckExtent();
+	}
+
+	template <typename U, typename A, typename C,
+			  typename = typename detail::EnableIfSpanConvertible<const U, T>::type>
+	span(const scpp::vector<U, A, C>& v)
+	: data_(v.empty() ? NULL : &v.front()), size_(v.size()) {
+		CheckExtent();
+	}
+
+	// The temporary would be destroyed before the span is used.
+	template <typename U, typename A, typename C>
+	span(const scpp::vector<U, A, C>&& v) = delete;
+
+	template <typename U, unsigned N, typename C,
+			  typename = typename detail::EnableIfSpanConvertible<U, T>::type>
+	span(scpp::array<U, N, C>& a)
+	: data_(a.begin()), size_(N) {
+		CheckExtent();
+	}
+
+	template <typename U, unsigned N, typename C,
+			  typename = typename detail::EnableIfSpanConvertible<const U, T>::type>
+	span(const scpp::array<U, N, C>& a)
+	: data_(a.begin()), size_(N) {
+		CheckExtent();
+	}
+
+	template <typename U, unsigned N, typename C>
+	span(const scpp::array<U, N, C>&& a) = delete;
+
+	// Conversion e.g. from span<T> to span<const T>, or between extents.
+	template <typename U, unsigned64 E,
+			  typename = typename detail::EnableIfSpanConvertible<U, T>::type>
+	span(const span<U, E>& that)
+	: data_(that.data()), size_(that.size()) {
+		CheckExtent();
+	}
+
+	// Note: we do not provide a copy-ctor and assignment operator.
+	// we rely on default versions of these methods generated by the compiler.
+
+	size_type size() const { return Extent == dynamic_extent ? size_ : Extent; }
+	size_type size_bytes() const { return size() * sizeof(T); }
+	bool empty() const { return size() == 0; }
+
+	T& operator [] (size_type index) const {
+		SCPP_TEST_ASSERT(index < size(),
+			"Index " << index << " must be less than " << size());
+		return data_[index];
+	}
+
+	T& front() const {
+		SCPP_TEST_ASSERT(!empty(), "front() called on empty span");
+		return data_[0];
+	}
+
+	T& back() const {
+		SCPP_TEST_ASSERT(!empty(), "back() called on empty span");
+		return data_[size() - 1];
+	}
+
+	// Accessors
+	T* data() const { return data_; }
+	iterator begin() const { return data_; }
+
+	// Returns pointer PAST the last element.
+	iterator end() const { return data_ + size(); }
+
+	// Returns count elements starting at offset,
+	// or all elements from offset to the end if count == dynamic_extent.
+	span<T> subspan(size_type offset, size_type count = dynamic_extent) const {
+		SCPP_TEST_ASSERT(offset <= size(),
+			"Offset " << offset << " must not exceed " << size());
+		if(count == dynamic_extent)
+			count = size() - offset;
+		SCPP_TEST_ASSERT(count <= size() - offset,
+			"Subspan [" << offset << ", " << offset << "+" << count
+			<< ") exceeds size " << size());
+		return span<T>(data_ + offset, count);
+	}
+
+	// First and last count elements.
+	span<T> first(size_type count) const { return subspan(0, count); }
+
+	span<T> last(size_type count) const {
+		SCPP_TEST_ASSERT(count <= size(),
+			"Count " << count << " must not exceed " << size());
+		return subspan(size() - count, count);
+	}
+
+  private:
+	T*			data_;
+	size_type	size_;
+
+	void CheckExtent() const {
+		SCPP_TEST_ASSERT(Extent == dynamic_extent || size_ == Extent,
+			"Span of fixed size " << Extent << " built from " << size_ << " elements");
+	}
+};
+
+// Returns span of all elements of the row of a RowMajor matrix.
+template <typename T, typename A, typename C, typename L>
+inline span<T> row_span(scpp::matrix<T, A, C, L>& m, typename scpp::matrix<T, A, C, L>::size_type row) {
+	return span<T>(m.row_data(row), m.num_cols());
+}
+
+template <typename T, typename A, typename C, typename L>
+inline span<const T> row_span(const scpp::matrix<T, A, C, L>& m,
+							  typename scpp::matrix<T, A, C, L>::size_type row) {
+	return span<const T>(m.row_data(row), m.num_cols());
+}
+
+// Returns span of all elements of the column of a ColMajor matrix.
+template <typename T, typename A, typename C, typename L>
+inline span<T> col_span(scpp::matrix<T, A, C, L>& m, typename scpp::matrix<T, A, C, L>::size_type col) {
+	return span<T>(m.col_data(col), m.num_rows());
+}
+
+template <typename T, typename A, typename C, typename L>
+inline span<const T> col_span(const scpp::matrix<T, A, C, L>& m,
+							  typename scpp::matrix<T, A, C, L>::size_type col) {
+	return span<const T>(m.col_data(col), m.num_rows());
+}
+
+} // namespace scpp
+
+
+template <typename T, unsigned64 Extent>
+inline
+std::ostream& operator << (std::ostream& os, const scpp::span<T, Extent>& s) {
+	for(unsigned64 i=0; i<s.size(); ++i) {
+		os << s[i];
+		if( i + 1 < s.size() )
+			os << " ";
+	}
+	return os;
+}
+
+#endif // __SCPP_SPAN_HPP_INCLUDED__
@@ -0,0 +1,467 @@
+/*
+
+ Safe C++, Or How to Avoid Most Common Mistakes in C++ Code
+ by Vladimir Kushnir, (O’Reilly).
+
+ Copyright 2012 Vladimir Kushnir, ISBN 9781449320935.
+
+ If you feel your use of code examples falls outside fair use or the
+ permission given above, feel free to contact us at permissions@oreilly.com.
+
+*/
+
+#ifndef __SCPP_TENSOR_HPP_INCLUDED__
+#define __SCPP_TENSOR_HPP_INCLUDED__
+
+#include <ostream>
+#include <type_traits>	// enable_if, is_convertible
+#include <utility>	// pair
+#include <vector>
+
+#include "scpp_assert.hpp"
+#include "scpp_check_policy.hpp"
+#include "scpp_types.hpp"
+
+/*
+	N-dimensional array, a generalization of scpp::matrix.
+	Features:
+		tensor<T, Rank> keeps all elements in one contiguous block,
+			the last axis varies fastest (row-major order).
+		tensor_view<T, Rank> is a non-owning view with a stride per axis.
+			slice(), range(), permute() and transpose() return views
+			of the same elements without copying them.
+		The multi-index operator () checks every index against its axis,
+			like matrix::index(), with the policy Check.
+		for_each_element(), transform() and reduce() run one loop over
+			several views at once, e.g. c = a * b + c without temporaries,
+			or a sum along any axis.
+
+	Typical use:
+
+		scpp::tensor<double, 3> prices({num_days, num_instruments, num_fields});
+		prices(day, instrument, field) = 1.5;
+		scpp::tensor<double, 2> totals({num_days, num_fields});
+		scpp::reduce(prices.view(), 1, totals.view(), 0.0, std::plus<double>());
+
+	A view must not outlive the tensor it was built from.
+	Requires C++11 (variadic templates).
+*/
+namespace scpp {
+
+template <typename T, unsigned Rank, typename Check = DefaultCheck>
+class tensor_view {
+	static_assert(Rank > 0, "tensor rank must be positive");
+
+  public:
+	typedef unsigned64	size_type;
+	typedef T			element_type;
+
+	enum { RANK = Rank };
+
+	tensor_view()
+	: data_(NULL) {
+		for(unsigned a=0; a<Rank; ++a)
+			shape_[a] = strides_[a] = 0;
+	}
+
+	// View of the elements data[i0 * strides[0] + i1 * strides[1] + ...].
+	tensor_view(T* data, const size_type (&shape)[Rank], const size_type (&strides)[Rank])
+	: data_(data) {
+		for(unsigned a=0; a<Rank; ++a) {
+			shape_[a] = shape[a];
+			strides_[a] = strides[a];
+		}
+	}
+
+	// Conversion from tensor_view<T> to tensor_view<const T>. Not from
+	// views of other element types, e.g. a derived class: their elements
+	// would be indexed with the wrong stride.
+	template <typename U, typename C, typename = typename std::enable_if<
+				  std::is_convertible<U(*)[], T(*)[]>::value>::type>
+	tensor_view(const tensor_view<U, Rank, C>& that)
+	: data_(that.data()) {
+		for(unsigned a=0; a<Rank; ++a) {
+			shape_[a] = that.shape(a);
+			strides_[a] = that.stride(a);
+		}
+	}
+
+	// Note: we do not provide a copy-ctor and assignment operator.
+	// we rely on default versions of these methods generated by the compiler.
+
+	T* data() const { return data_; }
+
+	size_type shape(unsigned axis) const {
+		SCPP_TEST_ASSERT(axis < Rank, "Axis " << axis << " must be less than " << Rank);
+		return shape_[axis];
+	}
+
+	// Distance in elements between neighbors along the axis.
+	size_type stride(unsigned axis) const {
+		SCPP_TEST_ASSERT(axis < Rank, "Axis " << axis << " must be less than " << Rank);
+		return strides_[axis];
+	}
+
+	// Total number of elements.
+	size_type size() const {
+		size_type n = 1;
+		for(unsigned a=0; a<Rank; ++a)
+			n *= shape_[a];
+		return n;
+	}
+
+	// True if the elements are contiguous in row-major order.
+	bool is_contiguous() const {
+		size_type expected = 1;
+		for(unsigned a=Rank; a-- > 0; ) {
+			if(shape_[a] != 1 && strides_[a] != expected)
+				return false;
+			expected *= shape_[a];
+		}
+		return true;
+	}
+
+	// Accessor: returns the element by Rank indices.
+	template <typename... Indices>
+	T& operator () (Indices... indices) const {
+		static_assert(sizeof...(Indices) == Rank, "wrong number of indices");
+		const size_type index[Rank] = { size_type(indices)... };
+		return data_[offset(index)];
+	}
+
+	// Offset of the element from data(), checked.
+	size_type offset(const size_type (&index)[Rank]) const {
+		size_type n = 0;
+		for(unsigned a=0; a<Rank; ++a) {
+			SCPP_CHECK(Check, index[a] < shape_[a],
+				"Index " << index[a] << " on axis " << a
+				<< " must be less than " << shape_[a]);
+			n += index[a] * strides_[a];
+		}
+		return n;
+	}
+
+	// View of Rank - 1 dimensions with the index on axis fixed,
+	// e.g. for a matrix slice(0, r) is the row r and slice(1, c) the column c.
+	tensor_view<T, Rank - 1, Check> slice(unsigned axis, size_type index) const {
+		static_assert(Rank > 1, "slice of a 1-dimensional tensor is an element");
+		SCPP_TEST_ASSERT(axis < Rank, "Axis " << axis << " must be less than " << Rank);
+		SCPP_CHECK(Check, index < shape_[axis],
+			"Index " << index << " on axis " << axis << " must be less than " << shape_[axis]);
+		size_type shape[Rank - 1], strides[Rank - 1];
+		for(unsigned a=0, b=0; a<Rank; ++a) {
+			if(a == axis)
+				continue;
+			shape[b] = shape_[a];
+			strides[b] = strides_[a];
+			++b;
+		}
+		return tensor_view<T, Rank - 1, Check>(data_ + index * strides_[axis], shape, strides);
+	}
+
+	// View of the indices [lo, hi) on axis.
+	tensor_view range(unsigned axis, size_type lo, size_type hi) const {
+		SCPP_TEST_ASSERT(axis < Rank, "Axis " << axis << " must be less than " << Rank);
+		SCPP_TEST_ASSERT(lo <= hi && hi <= shape_[axis],
+			"Range [" << lo << ", " << hi << ") on axis " << axis
+			<< " must be within [0, " << shape_[axis] << ")");
+		tensor_view v(*this);
+		v.data_ += lo * strides_[axis];
+		v.shape_[axis] = hi - lo;
+		return v;
+	}
+
+	// View with the axes reordered: axis a of the result is axis axes[a]
+	// of this view, e.g. permute(1, 0) of a matrix is its transpose.
+	template <typename... Axes>
+	tensor_view permute(Axes... axes) const {
+		static_assert(sizeof...(Axes) == Rank, "wrong number of axes");
+		const unsigned order[Rank] = { unsigned(axes)... };
+#ifdef SCPP_TEST_ASSERT_ON
+		bool seen[Rank] = {};
+		for(unsigned a=0; a<Rank; ++a) {
+			SCPP_TEST_ASSERT(order[a] < Rank && !seen[order[a]],
+				"Axes of permute() must be a permutation of 0 .. " << Rank - 1);
+			seen[order[a]] = true;
+		}
+#endif
+		tensor_view v(*this);
+		for(unsigned a=0; a<Rank; ++a) {
+			v.shape_[a] = shape_[order[a]];
+			v.strides_[a] = strides_[order[a]];
+		}
+		return v;
+	}
+
+	// View with two axes swapped.
+	tensor_view transpose(unsigned axis1, unsigned axis2) const {
+		SCPP_TEST_ASSERT(axis1 < Rank && axis2 < Rank,
+			"Axes " << axis1 << " and " << axis2 << " must be less than " << Rank);
+		tensor_view v(*this);
+		std::swap(v.shape_[axis1], v.shape_[axis2]);
+		std::swap(v.strides_[axis1], v.strides_[axis2]);
+		return v;
+	}
+
+  private:
+	T*			data_;
+	size_type	shape_[Rank];
+	size_type	strides_[Rank];
+};
+
+// Owns the elements, contiguous in row-major order.
+// The allocator A could be e.g. scpp::ArenaAllocator<T> (see scpp_arena.hpp).
+// The checks are controlled by the policy Check (see scpp_check_policy.hpp).
+template <typename T, unsigned Rank, typename A = std::allocator<T>, typename Check = DefaultCheck>
+class tensor {
+	static_assert(Rank > 0, "tensor rank must be positive");
+
+  public:
+	typedef unsigned64	size_type;
+	typedef T			element_type;
+
+	enum { RANK = Rank };
+
+	explicit tensor(const size_type (&shape)[Rank], const T& init_value = T(), const A& alloc = A())
+	: data_(NumElements(shape), init_value, alloc) {
+		size_type stride = 1;
+		for(unsigned a=Rank; a-- > 0; ) {
+			SCPP_CHECK(Check, shape[a] > 0,
+				"Size of axis " << a << " of a tensor must be positive");
+			shape_[a] = shape[a];
+			strides_[a] = stride;
+			stride *= shape[a];
+		}
+	}
+
+	// Note: we do not provide a copy-ctor and assignment operator.
+	// we rely on default versions of these methods generated by the compiler.
+
+	size_type shape(unsigned axis) const {
+		SCPP_TEST_ASSERT(axis < Rank, "Axis " << axis << " must be less than " << Rank);
+		return shape_[axis];
+	}
+
+	size_type size() const { return data_.size(); }
+
+	T* data() { return &data_[0]; }
+	const T* data() const { return &data_[0]; }
+
+	// Accessors: return element by Rank indices.
+	template <typename... Indices>
+	T& operator () (Indices... indices) {
+		static_assert(sizeof...(Indices) == Rank, "wrong number of indices");
+		const size_type index[Rank] = { size_type(indices)... };
+		return data_[offset(index)];
+	}
+
+	template <typename... Indices>
+	const T& operator () (Indices... indices) const {
+		static_assert(sizeof...(Indices) == Rank, "wrong number of indices");
+		const size_type index[Rank] = { size_type(indices)... };
+		return data_[offset(index)];
+	}
+
+	// View of all elements, see tensor_view for slicing and permuting.
+	tensor_view<T, Rank, Check> view() {
+		return tensor_view<T, Rank, Check>(&data_[0], shape_, strides_);
+	}
+
+	tensor_view<const T, Rank, Check> view() const {
+		return tensor_view<const T, Rank, Check>(&data_[0], shape_, strides_);
+	}
+
+  private:
+	size_type			shape_[Rank];
+	size_type			strides_[Rank];
+	std::vector<T, A>	data_;
+
+	static size_type NumElements(const size_type (&shape)[Rank]) {
+		size_type n = 1;
+		for(unsigned a=0; a<Rank; ++a) {
+			SCPP_ASSERT(!__builtin_mul_overflow(n, shape[a], &n),
+				"Tensor size is too large: overflow on axis " << a);
+		}
+		return n;
+	}
+
+	size_type offset(const size_type (&index)[Rank]) const {
+		size_type n = 0;
+		for(unsigned a=0; a<Rank; ++a) {
+			SCPP_CHECK(Check, index[a] < shape_[a],
+				"Index " << index[a] << " on axis " << a
+				<< " must be less than " << shape_[a]);
+			n += index[a] * strides_[a];
+		}
+		return n;
+	}
+};
+
+namespace detail {
+
+template <typename View>
+struct TensorRow {
+	typedef std::pair<typename View::element_type*, unsigned64> type;
+};
+
+template <typename F, typename... Pointers>
+inline void TensorApplyRow(F& f, unsigned64 n, Pointers... rows) {
+	for(unsigned64 i=0; i<n; ++i)
+		f(rows.first[i * rows.second]...);
+}
+
+template <typename F, typename... Pointers>
+inline void TensorApplyContiguous(F& f, unsigned64 n, Pointers... p) {
+	for(unsigned64 i=0; i<n; ++i)
+		f(p[i]...);
+}
+
+inline bool AllContiguous() { return true; }
+
+template <typename View, typename... Views>
+inline bool AllContiguous(const View& v, const Views&... views) {
+	return v.is_contiguous() && AllContiguous(views...);
+}
+
+template <unsigned Rank, typename... Views>
+struct AllOfRank {
+	enum { value = true };
+};
+
+template <unsigned Rank, typename View, typename... Views>
+struct AllOfRank<Rank, View, Views...> {
+	enum { value = unsigned(View::RANK) == Rank && AllOfRank<Rank, Views...>::value };
+};
+
+template <typename View>
+inline typename View::size_type RowOffset(const View& v, const unsigned64* index) {
+	typename View::size_type n = 0;
+	for(unsigned a=0; a+1<View::RANK; ++a)
+		n += index[a] * v.stride(a);
+	return n;
+}
+} // namespace detail
+
+/*
+	Calls f(x0, x1, ...) for every multi-index, where x0, x1, ... are
+	the elements of the views with this index. All views must have the
+	same rank (checked at compile time) and the same shape. If all of them are contiguous, it is one flat loop,
+	otherwise one loop along the last axis for every index of the others.
+*/
+template <typename F, typename View, typename... Views>
+void for_each_element(F f, const View& first, const Views&... views) {
+	const unsigned Rank = View::RANK;
+	static_assert(detail::AllOfRank<Rank, Views...>::value,
+		"all tensor views must have the same rank");
+#ifdef SCPP_TEST_ASSERT_ON
+	for(unsigned a=0; a<Rank; ++a) {
+		const unsigned64 shapes[] = { first.shape(a), views.shape(a)... };
+		for(unsigned k=1; k<sizeof...(Views) + 1; ++k)
+			SCPP_TEST_ASSERT(shapes[k] == shapes[0],
+				"Tensor shapes differ on axis " << a << ": "
+				<< shapes[0] << " and " << shapes[k]);
+	}
+#endif
+
+	if(first.size() == 0)
+		return;
+
+	if(detail::AllContiguous(first, views...)) {
+		detail::TensorApplyContiguous(f, first.size(), first.data(), views.data()...);
+		return;
+	}
+
+	const unsigned64 n = first.shape(Rank - 1);
+	unsigned64 index[Rank] = {};
+	for(;;) {
+		detail::TensorApplyRow(f, n,
+			typename detail::TensorRow<View>::type(
+				first.data() + detail::RowOffset(first, index), first.stride(Rank - 1)),
+			typename detail::TensorRow<Views>::type(
+				views.data() + detail::RowOffset(views, index), views.stride(Rank - 1))...);
+
+		// Next index of the outer axes, the last one varies fastest.
+		unsigned a = Rank - 1;
+		while(a > 0) {
+			--a;
+			if(++index[a] < first.shape(a))
+				break;
+			index[a] = 0;
+			if(a == 0)
+				return;
+		}
+		if(Rank == 1)
+			return;
+	}
+}
+
+// out = f(in0, in1, ...) element by element, in one pass.
+template <typename Out, typename F, typename... Ins>
+void transform(const Out& out, F f, const Ins&... ins) {
+	for_each_element(
+		[&f](typename Out::element_type& x, typename Ins::element_type&... y) { x = f(y...); },
+		out, ins...);
+}
+
+/*
+	Reduces in along axis into out, which has the shape of in without
+	that axis: out(..) = f(..f(f(init, in(.., 0, ..)), in(.., 1, ..)).., in(.., n-1, ..)).
+	The previous values of out are overwritten.
+*/
+template <typename T, unsigned Rank, typename C, typename U, typename C2, typename F>
+void reduce(const tensor_view<T, Rank, C>& in, unsigned axis,
+			const tensor_view<U, Rank - 1, C2>& out, const U& init, F f) {
+	static_assert(Rank > 1, "use reduce_all() for 1-dimensional tensors");
+	SCPP_TEST_ASSERT(axis < Rank, "Axis " << axis << " must be less than " << Rank);
+
+	// out seen as a tensor of Rank dimensions with stride 0 along axis,
+	// so that all elements along the axis go to the same output element.
+	unsigned64 shape[Rank], strides[Rank];
+	for(unsigned a=0, b=0; a<Rank; ++a) {
+		if(a == axis) {
+			shape[a] = in.shape(a);
+			strides[a] = 0;
+		} else {
+			SCPP_TEST_ASSERT(out.shape(b) == in.shape(a),
+				"Output shape differs from input on axis " << a << ": "
+				<< out.shape(b) << " and " << in.shape(a));
+			shape[a] = out.shape(b);
+			strides[a] = out.stride(b);
+			++b;
+		}
+	}
+	tensor_view<U, Rank, C2> accumulator(out.data(), shape, strides);
+
+	for_each_element([&init](U& x) { x = init; }, out);
+	for_each_element([&f](U& acc, const T& x) { acc = f(acc, x); }, accumulator, in);
+}
+
+// Reduces all elements of in: f(..f(f(init, x0), x1).., xn).
+template <typename T, unsigned Rank, typename C, typename U, typename F>
+U reduce_all(const tensor_view<T, Rank, C>& in, U init, F f) {
+	for_each_element([&init, &f](const T& x) { init = f(init, x); }, in);
+	return init;
+}
+
+} // namespace scpp
+
+// Prints the elements of the last axis separated by spaces, one line per
+// index of the other axes.
+template <typename T, unsigned Rank, typename C>
+inline
+std::ostream& operator << (std::ostream& os, const scpp::tensor_view<T, Rank, C>& v) {
+	const unsigned64 n = v.shape(Rank - 1);
+	unsigned64 i = 0;
+	scpp::for_each_element([&os, &i, n](const T& x) {
+		os << x << (++i % n == 0 ? "\n" : " ");
+	}, v);
+	return os;
+}
+
+template <typename T, unsigned Rank, typename A, typename C>
+inline
+std::ostream& operator << (std::ostream& os, const scpp::tensor<T, Rank, A, C>& t) {
+	return os << t.view();
+}
+
+#endif // __SCPP_TENSOR_HPP_INCLUDED__
@@ -13,12 +13,97 @@
 #ifndef __SCPP_TYPES_HPP_INCLUDED__
 #define __SCPP_TYPES_HPP_INCLUDED__
 
+#include <limits>
 #include <ostream>
 #include "scpp_assert.hpp"
 
+namespace scpp {
+/*
+	Arithmetic policies of TNumber, for integer types only.
+		WrapArithmetic		-- the same as for T: the result silently wraps
+							   around on overflow. This is the default.
+		CheckedArithmetic	-- overflow is a bug: calls SCPP_ASSERT.
+		SaturatingArithmetic
+							-- on overflow the result is clamped
+							   to the min or max value of T.
+	The checks use the GCC and Clang __builtin_*_overflow intrinsics,
+	which compile to the plain operation followed by a jump on the
+	overflow flag. See also scpp_checked_math.hpp for arrays.
+*/
+struct WrapArithmetic {
+	template <typename T> static T Add(T a, T b) { return a + b; }
+	template <typename T> static T Sub(T a, T b) { return a - b; }
+	template <typename T> static T Mul(T a, T b) { return a * b; }
+	template <typename T> static T Div(T a, T b) { return a / b; }
+};
+
+struct CheckedArithmetic {
+	template <typename T> static T Add(T a, T b) {
+		T r;
+		SCPP_ASSERT(!__builtin_add_overflow(a, b, &r),
+			"Overflow in " << a << " + " << b);
+		return r;
+	}
+
+	template <typename T> static T Sub(T a, T b) {
+		T r;
+		SCPP_ASSERT(!__builtin_sub_overflow(a, b, &r),
+			"Overflow in " << a << " - " << b);
+		return r;
+	}
+
+	template <typename T> static T Mul(T a, T b) {
+		T r;
+		SCPP_ASSERT(!__builtin_mul_overflow(a, b, &r),
+			"Overflow in " << a << " * " << b);
+		return r;
+	}
+
+	template <typename T> static T Div(T a, T b) {
+		SCPP_ASSERT(!(std::numeric_limits<T>::is_signed
+					  && a == std::numeric_limits<T>::min() && b == T(-1)),
+			"Overflow in " << a << " / " << b);
+		return a / b;
+	}
+};
+
+struct SaturatingArithmetic {
+	template <typename T> static T Add(T a, T b) {
+		T r;
+		if(__builtin_add_overflow(a, b, &r))
+			return b < T(0) ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+		return r;
+	}
+
+	template <typename T> static T Sub(T a, T b) {
+		T r;
+		if(__builtin_sub_overflow(a, b, &r))
+			return b > T(0) ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+		return r;
+	}
+
+	template <typename T> static T Mul(T a, T b) {
+		T r;
+		if(__builtin_mul_overflow(a, b, &r))
+			return (a < T(0)) != (b < T(0)) ? std::numeric_limits<T>::min()
+											: std::numeric_limits<T>::max();
+		return r;
+	}
+
+	template <typename T> static T Div(T a, T b) {
+		if(std::numeric_limits<T>::is_signed
+			&& a == std::numeric_limits<T>::min() && b == T(-1))
+			return std::numeric_limits<T>::max();
+		return a / b;
+	}
+};
+} // namespace scpp
+
 // Template wrapper around a built-in type T.
 // Behaves exactly as T, except initialized by default to 0.
-template<typename T>
+// The operators ++, +=, -=, *= and /= follow the arithmetic policy
+// Arithmetic (see above); binary operators like a + b work on T.
+template<typename T, typename Arithmetic = scpp::WrapArithmetic>
 class TNumber {
 public:
 	TNumber(const T& x=0)
@@ -34,42 +119,42 @@ public:
 
 	// postfix operator x++
 	TNumber operator ++ (int) {
-		TNumber<T> copy(*this);
-		++data_;
+		TNumber<T, Arithmetic> copy(*this);
+		data_ = Arithmetic::Add(data_, T(1));
 		return copy;
 	}
 
 	// prefix operator ++x
 	TNumber& operator ++ () {
-		++data_;
+		data_ = Arithmetic::Add(data_, T(1));
 		return *this;
 	}
 
 	TNumber& operator += (T x) {
-		data_ += x;
+		data_ = Arithmetic::Add(data_, x);
 		return *this;
 	}
 
 	TNumber& operator -= (T x) {
-		data_ -= x;
+		data_ = Arithmetic::Sub(data_, x);
 		return *this;
 	}
 
 	TNumber& operator *= (T x) {
-		data_ *= x;
+		data_ = Arithmetic::Mul(data_, x);
 		return *this;
 	}
 
 	TNumber& operator /= (T x) {
 		SCPP_TEST_ASSERT(x!=0, "Attempt to divide by 0");
-		data_ /= x;
+		data_ = Arithmetic::Div(data_, x);
 		return *this;
 	}
 
 	T operator / (T x) 
 	{
 		SCPP_TEST_ASSERT(x!=0, "Attempt to divide by 0");
-		return data_ / x;
+		return Arithmetic::Div(data_, x);
 	}
 
 private:
@@ -87,6 +172,18 @@ typedef		TNumber<float>		Float;
 typedef		TNumber<double>		Double;
 typedef		TNumber<char>		Char;
 
+// Integers that call the error handler on overflow.
+typedef		TNumber<int, scpp::CheckedArithmetic>			CheckedInt;
+typedef		TNumber<unsigned, scpp::CheckedArithmetic>		CheckedUnsigned;
+typedef		TNumber<int64, scpp::CheckedArithmetic>			CheckedInt64;
+typedef		TNumber<unsigned64, scpp::CheckedArithmetic>	CheckedUnsigned64;
+
+// Integers that are clamped to their range on overflow.
+typedef		TNumber<int, scpp::SaturatingArithmetic>		SaturatingInt;
+typedef		TNumber<unsigned, scpp::SaturatingArithmetic>	SaturatingUnsigned;
+typedef		TNumber<int64, scpp::SaturatingArithmetic>		SaturatingInt64;
+typedef		TNumber<unsigned64, scpp::SaturatingArithmetic>	SaturatingUnsigned64;
+
 class Bool {
 public:
 	Bool(bool x=false)
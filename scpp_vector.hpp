@@ -15,53 +15,77 @@
 
 #include <vector>
 #include "scpp_assert.hpp"
+#include "scpp_check_policy.hpp"
+#include "scpp_types.hpp"
 
 
 namespace scpp {
 	
 // Wrapper around std::vector, has temporary sanity checks in the operators [].
-template <typename T>
-class vector : public std::vector<T> {
+// The allocator A could be e.g. scpp::ArenaAllocator<T> (see scpp_arena.hpp).
+// The checks are controlled by the policy Check (see scpp_check_policy.hpp).
+// Sizes and indices are 64-bit.
+template <typename T, typename A = std::allocator<T>, typename Check = DefaultCheck>
+class vector : public std::vector<T, A> {
  public:
-	typedef unsigned size_type;	
+	typedef unsigned64 size_type;	
+	typedef std::vector<T, A> base_type;
 	
 	// Most commonly used constructors:
 	explicit vector( size_type n = 0  )
-	: std::vector<T>(n)
+	: std::vector<T, A>(n)
 	{}
 	
 	vector( size_type n, const T& value )
-	: std::vector<T>(n, value)
+	: std::vector<T, A>(n, value)
 	{}
 
 	template <class InputIterator> vector ( InputIterator first, InputIterator last )
-	: std::vector<T>(first, last)
+	: std::vector<T, A>(first, last)
+	{}
+
+	// Same as above, with memory taken from the allocator alloc.
+	explicit vector( const A& alloc )
+	: std::vector<T, A>(alloc)
+	{}
+
+	vector( size_type n, const A& alloc )
+	: std::vector<T, A>(n, T(), alloc)
+	{}
+
+	vector( size_type n, const T& value, const A& alloc )
+	: std::vector<T, A>(n, value, alloc)
+	{}
+
+	template <class InputIterator>
+	vector ( InputIterator first, InputIterator last, const A& alloc )
+	: std::vector<T, A>(first, last, alloc)
 	{}
 	
 	// Note: we do not provide a copy-ctor and assignment operator.
 	// we rely on default versions of these methods generated by the compiler.
 	
 	T& operator [] (size_type index) {
-		SCPP_TEST_ASSERT(index < std::vector<T>::size(),
+		SCPP_CHECK(Check, index < base_type::size(),
 			"Index " << index << " must be less than "
-			<< std::vector<T>::size());
-		return std::vector<T>::operator[](index);
+			<< base_type::size());
+		return base_type::operator[](index);
 	}
 
 	const T& operator [] (size_type index) const {
-		SCPP_TEST_ASSERT(index < std::vector<T>::size(),
+		SCPP_CHECK(Check, index < base_type::size(),
 			"Index " << index << " must be less than "
-			<< std::vector<T>::size());
-		return std::vector<T>::operator[](index);
+			<< base_type::size());
+		return base_type::operator[](index);
 	}
 };
 } // namespace scpp
 
 
-template <typename T>
+template <typename T, typename A, typename Check>
 inline
-std::ostream& operator << (std::ostream& os, const scpp::vector<T>& v) {
-	for(unsigned i=0; i<v.size(); ++i) {
+std::ostream& operator << (std::ostream& os, const scpp::vector<T, A, Check>& v) {
+	for(typename scpp::vector<T, A, Check>::size_type i=0; i<v.size(); ++i) {
 		os << v[i];
 		if( i + 1 < v.size() )
 			os << " ";